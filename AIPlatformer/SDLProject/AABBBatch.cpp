@@ -0,0 +1,195 @@
+#include "AABBBatch.h"
+#include <math.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define AABB_BATCH_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(AABB_BATCH_X86) && !defined(_MSC_VER)
+#define AABB_BATCH_AVX2 1
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+static AABBBatch::Path g_path     = AABBBatch::SCALAR;
+static bool            g_path_set = false;
+
+// ————— KERNELS ————— //
+// Each kernel handles [0, count) in whatever step it likes and returns how far it got;
+// the scalar loop finishes the rest
+static int overlap_scalar(float center_x, float center_y, float width, float height,
+                          const float *centers_x, const float *centers_y, const float *widths, const float *heights,
+                          int first, int count, uint64_t *hit_mask)
+{
+    for (int i = first; i < count; i++)
+    {
+        float x_distance = fabs(center_x - centers_x[i]) - ((width  + widths[i])  / 2.0f);
+        float y_distance = fabs(center_y - centers_y[i]) - ((height + heights[i]) / 2.0f);
+        
+        if (x_distance < 0.0f && y_distance < 0.0f) hit_mask[i >> 6] |= (uint64_t) 1 << (i & 63);
+    }
+    
+    return count;
+}
+
+#ifdef AABB_BATCH_X86
+static int overlap_sse(float center_x, float center_y, float width, float height,
+                       const float *centers_x, const float *centers_y, const float *widths, const float *heights,
+                       int count, uint64_t *hit_mask)
+{
+    const __m128 sign_mask = _mm_set1_ps(-0.0f),
+                 half      = _mm_set1_ps(0.5f),
+                 zero      = _mm_setzero_ps(),
+                 x         = _mm_set1_ps(center_x),
+                 y         = _mm_set1_ps(center_y),
+                 w         = _mm_set1_ps(width),
+                 h         = _mm_set1_ps(height);
+    
+    // Build each 64-bit word of the mask in a register and store it once
+    int i = 0;
+    uint64_t bits = 0;
+    
+    for (; i + 4 <= count; i += 4)
+    {
+        // fabs(a - b) - (w_a + w_b) / 2, with the divide as an exact multiply by a half
+        __m128 x_distance = _mm_sub_ps(_mm_andnot_ps(sign_mask, _mm_sub_ps(x, _mm_loadu_ps(centers_x + i))),
+                                       _mm_mul_ps(_mm_add_ps(w, _mm_loadu_ps(widths + i)), half));
+        __m128 y_distance = _mm_sub_ps(_mm_andnot_ps(sign_mask, _mm_sub_ps(y, _mm_loadu_ps(centers_y + i))),
+                                       _mm_mul_ps(_mm_add_ps(h, _mm_loadu_ps(heights + i)), half));
+        
+        __m128 hits = _mm_and_ps(_mm_cmplt_ps(x_distance, zero), _mm_cmplt_ps(y_distance, zero));
+        bits |= (uint64_t) _mm_movemask_ps(hits) << (i & 63);
+        
+        if (((i + 4) & 63) == 0)
+        {
+            hit_mask[i >> 6] = bits;
+            bits = 0;
+        }
+    }
+    
+    if (i & 63) hit_mask[i >> 6] = bits;
+    return i;
+}
+#endif
+
+#ifdef AABB_BATCH_AVX2
+TARGET_AVX2
+static int overlap_avx2(float center_x, float center_y, float width, float height,
+                        const float *centers_x, const float *centers_y, const float *widths, const float *heights,
+                        int count, uint64_t *hit_mask)
+{
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f),
+                 half      = _mm256_set1_ps(0.5f),
+                 zero      = _mm256_setzero_ps(),
+                 x         = _mm256_set1_ps(center_x),
+                 y         = _mm256_set1_ps(center_y),
+                 w         = _mm256_set1_ps(width),
+                 h         = _mm256_set1_ps(height);
+    
+    int i = 0;
+    uint64_t bits = 0;
+    
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x_distance = _mm256_sub_ps(_mm256_andnot_ps(sign_mask, _mm256_sub_ps(x, _mm256_loadu_ps(centers_x + i))),
+                                          _mm256_mul_ps(_mm256_add_ps(w, _mm256_loadu_ps(widths + i)), half));
+        __m256 y_distance = _mm256_sub_ps(_mm256_andnot_ps(sign_mask, _mm256_sub_ps(y, _mm256_loadu_ps(centers_y + i))),
+                                          _mm256_mul_ps(_mm256_add_ps(h, _mm256_loadu_ps(heights + i)), half));
+        
+        __m256 hits = _mm256_and_ps(_mm256_cmp_ps(x_distance, zero, _CMP_LT_OQ),
+                                    _mm256_cmp_ps(y_distance, zero, _CMP_LT_OQ));
+        
+        bits |= (uint64_t) _mm256_movemask_ps(hits) << (i & 63);
+        
+        if (((i + 8) & 63) == 0)
+        {
+            hit_mask[i >> 6] = bits;
+            bits = 0;
+        }
+    }
+    
+    if (i & 63) hit_mask[i >> 6] = bits;
+    return i;
+}
+#endif
+
+static AABBBatch::Path best_available_path()
+{
+#ifdef AABB_BATCH_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return AABBBatch::AVX2;
+#endif
+#ifdef AABB_BATCH_X86
+    // Every x86-64 CPU has SSE2
+    return AABBBatch::SSE;
+#else
+    return AABBBatch::SCALAR;
+#endif
+}
+
+// ————— METHODS ————— //
+bool AABBBatch::overlap(float center_x, float center_y, float width, float height,
+                        const float *centers_x, const float *centers_y, const float *widths, const float *heights,
+                        int count, std::vector<uint64_t> &hit_mask)
+{
+    hit_mask.assign((count + 63) / 64, 0);
+    
+    int done = 0;
+    
+    switch (get_path())
+    {
+#ifdef AABB_BATCH_AVX2
+        case AVX2:
+            done = overlap_avx2(center_x, center_y, width, height, centers_x, centers_y, widths, heights,
+                                count, hit_mask.data());
+            break;
+#endif
+#ifdef AABB_BATCH_X86
+        case SSE:
+            done = overlap_sse(center_x, center_y, width, height, centers_x, centers_y, widths, heights,
+                               count, hit_mask.data());
+            break;
+#endif
+        default:
+            break;
+    }
+    
+    overlap_scalar(center_x, center_y, width, height, centers_x, centers_y, widths, heights,
+                   done, count, hit_mask.data());
+    
+    for (size_t word = 0; word < hit_mask.size(); word++)
+        if (hit_mask[word] != 0) return true;
+    
+    return false;
+}
+
+// ————— GETTERS ————— //
+AABBBatch::Path const AABBBatch::get_path()
+{
+    if (!g_path_set)
+    {
+        g_path     = best_available_path();
+        g_path_set = true;
+    }
+    
+    return g_path;
+}
+
+const char *const AABBBatch::get_path_name(Path path)
+{
+    switch (path)
+    {
+        case AVX2: return "avx2";
+        case SSE:  return "sse";
+        default:   return "scalar";
+    }
+}
+
+// ————— SETTERS ————— //
+void AABBBatch::set_path(Path path)
+{
+    Path best = best_available_path();
+    
+    g_path     = path > best ? best : path;
+    g_path_set = true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+/**
+    Tests one box against a packed list of boxes in one go. The list is given as
+    separate arrays of centres and full extents (the same widths and heights Entity and
+    EntityStore keep), and bit i of the hit mask is set when box i overlaps. The maths is
+    exactly Entity::check_collision's, so every path agrees with it bit for bit.
+
+    On x86 the widest path the CPU supports (AVX2, then SSE) is picked the first time
+    overlap() runs; everywhere else the scalar loop is used.
+*/
+class AABBBatch
+{
+public:
+    enum Path { SCALAR, SSE, AVX2 };
+    
+    // ————— METHODS ————— //
+    // hit_mask is resized to hold count bits; returns whether anything was hit
+    static bool overlap(float center_x, float center_y, float width, float height,
+                        const float *centers_x, const float *centers_y, const float *widths, const float *heights,
+                        int count, std::vector<uint64_t> &hit_mask);
+    
+    static bool const is_hit(const std::vector<uint64_t> &hit_mask, int index)
+    {
+        return (hit_mask[index >> 6] >> (index & 63)) & 1;
+    }
+    
+    // ————— GETTERS ————— //
+    static Path        const get_path();
+    static const char *const get_path_name(Path path);
+    
+    // ————— SETTERS ————— //
+    // Forces a path, e.g. to compare them; asking for one the CPU lacks falls back to
+    // the best one it has
+    static void set_path(Path path);
+};
@@ -0,0 +1,93 @@
+#define LOG(argument) std::cout << argument << '\n'
+#define MIXING_CHANNELS 16
+
+#include "AudioSystem.h"
+#include <iostream>
+#include "Utility.h"
+
+// Everything the scenes play; decoded once when the device opens
+const char *const BANK_SOUNDS[] = { "assets/aijump.wav", "assets/winlevel.wav", "assets/aihit.wav" };
+
+constexpr char BANK_MUSIC[] = "assets/aiplatbgm.mp3";
+
+static bool       g_is_open       = false;
+static int        g_frequency     = 0,
+                  g_buffer_size   = 0,
+                  g_sounds_played = 0;
+
+static std::vector<Mix_Chunk*> g_bank_sounds;
+static Mix_Music              *g_bank_music    = nullptr;
+static Mix_Music              *g_playing_music = nullptr;
+
+bool AudioSystem::open(int frequency, int channels, int buffer_size)
+{
+    if (g_is_open) return true;
+    
+    if (Mix_OpenAudio(frequency, MIX_DEFAULT_FORMAT, channels, buffer_size) < 0)
+    {
+        LOG("Unable to open audio: " << Mix_GetError());
+        return false;
+    }
+    
+    // The device may not give us the rate we asked for
+    Uint16 format;
+    if (Mix_QuerySpec(&g_frequency, &format, &channels) == 0) g_frequency = frequency;
+    
+    g_is_open     = true;
+    g_buffer_size = buffer_size;
+    Mix_AllocateChannels(MIXING_CHANNELS);
+    
+    for (const char *filepath : BANK_SOUNDS)
+        g_bank_sounds.push_back(Utility::acquire_sound(filepath));
+    
+    g_bank_music = Utility::acquire_music(BANK_MUSIC);
+    
+    return true;
+}
+
+void AudioSystem::close()
+{
+    if (!g_is_open) return;
+    
+    Mix_HaltMusic();
+    g_playing_music = nullptr;
+    
+    for (Mix_Chunk *&sound : g_bank_sounds) Utility::release_sound(sound);
+    g_bank_sounds.clear();
+    Utility::release_music(g_bank_music);
+    
+    Mix_CloseAudio();
+    g_is_open = false;
+}
+
+void AudioSystem::play_music(Mix_Music *music, int volume)
+{
+    if (music == nullptr) return;
+    
+    if (music != g_playing_music || !Mix_PlayingMusic())
+    {
+        Mix_PlayMusic(music, -1);
+        g_playing_music = music;
+    }
+    
+    Mix_VolumeMusic(volume);
+}
+
+int AudioSystem::play_sound(Mix_Chunk *sound)
+{
+    if (sound == nullptr) return -1;
+    
+    g_sounds_played++;
+    return Mix_PlayChannel(-1, sound, 0);
+}
+
+bool const AudioSystem::get_is_open() { return g_is_open; }
+
+int const AudioSystem::get_buffer_size() { return g_buffer_size; }
+
+float const AudioSystem::get_buffer_latency_ms()
+{
+    return g_frequency > 0 ? 1000.0f * g_buffer_size / g_frequency : 0.0f;
+}
+
+int const AudioSystem::get_sounds_played() { return g_sounds_played; }
@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include <SDL.h>
+#include <SDL_mixer.h>
+
+/**
+    The one audio device and the clips that stay decoded for as long as it's open.
+    open() decodes every sound effect into a resident bank and loads the music
+    stream, so a scene's acquire_sound()/acquire_music() is always a cache hit and
+    nothing is decoded at a level change. Music started with play_music() carries on
+    across scenes rather than restarting.
+
+    The mixer fills buffer_size frames at a time, so a sound started mid-buffer is
+    heard up to one buffer later: 4096 frames at 44.1 kHz is ~93 ms, 512 is ~12 ms.
+*/
+class AudioSystem
+{
+public:
+    // ————— METHODS ————— //
+    static bool open(int frequency, int channels, int buffer_size);
+    static void close();
+    
+    // Starts music looping, or only sets the volume if it's already the one playing
+    static void play_music(Mix_Music *music, int volume);
+    static int  play_sound(Mix_Chunk *sound);
+    
+    // ————— GETTERS ————— //
+    static bool  const get_is_open();
+    static int   const get_buffer_size();
+    static float const get_buffer_latency_ms();
+    static int   const get_sounds_played();
+};
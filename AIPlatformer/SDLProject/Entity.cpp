@@ -12,6 +12,10 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
 #include "Entity.h"
+#include "SpriteBatch.h"
+#include "EntityStore.h"
+#include "Simulation.h"
+#include "Profiler.h"
 
 bool Entity::check_collision_with_enemies(Entity* enemies, int enemy_count)
 {
@@ -28,6 +32,33 @@ bool Entity::check_collision_with_enemies(Entity* enemies, int enemy_count)
     return false;
 }
 
+bool Entity::check_collision_with_enemies(EntityStore* enemies, SpatialHash *broad_phase)
+{
+    if (broad_phase == nullptr)
+    {
+        if (!Simulation::get_is_deterministic()) return enemies->overlap(m_position, m_width, m_height, m_hit_mask);
+        
+        for (int i = 0; i < enemies->get_count(); i++)
+            if (check_collision(enemies->get_position(i), enemies->get_width(i), enemies->get_height(i))) return true;
+        
+        return false;
+    }
+    
+    const std::vector<int> &candidates = broad_phase->query(m_position, m_width, m_height);
+    
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        int index = candidates[i];
+        
+        if (check_collision(enemies->get_position(index), enemies->get_width(index), enemies->get_height(index)))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 
 void Entity::ai_activate(Entity *player)
 {
@@ -69,7 +100,15 @@ void Entity::ai_guard(Entity *player)
 {
     switch (m_ai_state) {
         case IDLE:
-            if (glm::distance(m_position, player->get_position()) < 3.0f) m_ai_state = WALKING;
+            if (Simulation::get_is_deterministic())
+            {
+                fixed_t x_distance = FixedPoint::from_float(m_position.x) - FixedPoint::from_float(player->get_position().x),
+                        y_distance = FixedPoint::from_float(m_position.y) - FixedPoint::from_float(player->get_position().y);
+                
+                if (FixedPoint::mul(x_distance, x_distance) + FixedPoint::mul(y_distance, y_distance) < FixedPoint::from_int(3 * 3))
+                    m_ai_state = WALKING;
+            }
+            else if (glm::distance(m_position, player->get_position()) < 3.0f) m_ai_state = WALKING;
             break;
             
         case WALKING:
@@ -139,13 +178,13 @@ Entity::~Entity() { }
 
 void Entity::draw_sprite_from_texture_atlas(ShaderProgram* program, GLuint texture_id, int index)
 {
-    // Step 1: Calculate the UV location of the indexed frame
-    float u_coord = (float)(index % m_animation_cols) / (float)m_animation_cols;
-    float v_coord = (float)(index / m_animation_cols) / (float)m_animation_rows;
+    // Step 1: Calculate the UV location of the indexed frame, within the sheet's atlas region
+    float u_coord = m_atlas_region.map_u((float)(index % m_animation_cols) / (float)m_animation_cols);
+    float v_coord = m_atlas_region.map_v((float)(index / m_animation_cols) / (float)m_animation_rows);
 
     // Step 2: Calculate its UV size
-    float width = 1.0f / (float)m_animation_cols;
-    float height = 1.0f / (float)m_animation_rows;
+    float width = m_atlas_region.width / (float)m_animation_cols;
+    float height = m_atlas_region.height / (float)m_animation_rows;
 
     // Step 3: Just as we have done before, match the texture coordinates to the vertices
     float tex_coords[] =
@@ -177,179 +216,228 @@ void Entity::draw_sprite_from_texture_atlas(ShaderProgram* program, GLuint textu
 
 bool const Entity::check_collision(Entity* other) const
 {
-    float x_distance = fabs(m_position.x - other->m_position.x) - ((m_width + other->m_width) / 2.0f);
-    float y_distance = fabs(m_position.y - other->m_position.y) - ((m_height + other->m_height) / 2.0f);
+    return check_collision(other->m_position, other->m_width, other->m_height);
+}
+
+bool const Entity::check_collision(glm::vec3 other_position, float other_width, float other_height) const
+{
+    if (Simulation::get_is_deterministic())
+    {
+        fixed_t x_distance = FixedPoint::abs(FixedPoint::from_float(m_position.x) - FixedPoint::from_float(other_position.x)) -
+                             (FixedPoint::from_float(m_width) + FixedPoint::from_float(other_width)) / 2;
+        fixed_t y_distance = FixedPoint::abs(FixedPoint::from_float(m_position.y) - FixedPoint::from_float(other_position.y)) -
+                             (FixedPoint::from_float(m_height) + FixedPoint::from_float(other_height)) / 2;
+        
+        return x_distance < 0 && y_distance < 0;
+    }
+    
+    float x_distance = fabs(m_position.x - other_position.x) - ((m_width + other_width) / 2.0f);
+    float y_distance = fabs(m_position.y - other_position.y) - ((m_height + other_height) / 2.0f);
 
     return x_distance < 0.0f && y_distance < 0.0f;
 }
 
 
+// How deep two boxes overlap along one axis
+static float axis_overlap(float position, float other_position, float size, float other_size)
+{
+    if (Simulation::get_is_deterministic())
+    {
+        fixed_t distance = FixedPoint::abs(FixedPoint::from_float(position) - FixedPoint::from_float(other_position));
+        return FixedPoint::to_float(FixedPoint::abs(distance - FixedPoint::from_float(size) / 2 - FixedPoint::from_float(other_size) / 2));
+    }
+    
+    float distance = fabs(position - other_position);
+    return fabs(distance - (size / 2.0f) - (other_size / 2.0f));
+}
 
-void const Entity::check_collision_y(Entity *collidable_entities, int collidable_entity_count)
+void const Entity::resolve_collision_y(glm::vec3 other_position, float other_width, float other_height, EntityType other_type)
 {
-    for (int i = 0; i < collidable_entity_count; i++)
+    if (check_collision(other_position, other_width, other_height))
     {
-        Entity *collidable_entity = &collidable_entities[i];
+        float y_overlap = axis_overlap(m_position.y, other_position.y, m_height, other_height);
         
-        if (check_collision(collidable_entity))
+        if (other_type == ENEMY)
         {
-            float y_distance = fabs(m_position.y - collidable_entity->m_position.y);
-            float y_overlap = fabs(y_distance - (m_height / 2.0f) - (collidable_entity->m_height / 2.0f));
-            
-            if (collidable_entity->get_entity_type() == ENEMY)
-            {
-                // Still set flags (if needed for game logic like detecting top collision)
-                if (m_velocity.y > 0)
-                    m_collided_top = true;
-                else if (m_velocity.y < 0)
-                    m_collided_bottom = true;
-                
-                continue;
-            }
-            
+            // Still set flags (if needed for game logic like detecting top collision)
             if (m_velocity.y > 0)
-            {
-                m_position.y   -= y_overlap;
-                m_velocity.y    = 0;
+                m_collided_top = true;
+            else if (m_velocity.y < 0)
+                m_collided_bottom = true;
+            
+            return;
+        }
+        
+        if (m_velocity.y > 0)
+        {
+            m_position.y   -= y_overlap;
+            m_velocity.y    = 0;
 
-                // Collision!
-                m_collided_top  = true;
-            } else if (m_velocity.y < 0)
-            {
-                m_position.y      += y_overlap;
-                m_velocity.y       = 0;
+            // Collision!
+            m_collided_top  = true;
+        } else if (m_velocity.y < 0)
+        {
+            m_position.y      += y_overlap;
+            m_velocity.y       = 0;
 
-                // Collision!
-                m_collided_bottom  = true;
-            }
+            // Collision!
+            m_collided_bottom  = true;
         }
     }
 }
 
-void const Entity::check_collision_x(Entity *collidable_entities, int collidable_entity_count)
+void const Entity::resolve_collision_x(glm::vec3 other_position, float other_width, float other_height, EntityType other_type)
 {
-    for (int i = 0; i < collidable_entity_count; i++)
+    if (check_collision(other_position, other_width, other_height))
     {
-        Entity *collidable_entity = &collidable_entities[i];
+        float x_overlap = axis_overlap(m_position.x, other_position.x, m_width, other_width);
         
-        if (check_collision(collidable_entity))
+        if (other_type == ENEMY)
         {
-            float x_distance = fabs(m_position.x - collidable_entity->m_position.x);
-            float x_overlap = fabs(x_distance - (m_width / 2.0f) - (collidable_entity->m_width / 2.0f));
-            
-            if (collidable_entity->get_entity_type() == ENEMY)
-                        {
-                            if (m_velocity.x > 0)
-                                m_collided_right = true;
-                            else if (m_velocity.x < 0)
-                                m_collided_left = true;
-
-                            continue;
-                        }
-            
             if (m_velocity.x > 0)
-            {
-                m_position.x     -= x_overlap;
-                m_velocity.x      = 0;
+                m_collided_right = true;
+            else if (m_velocity.x < 0)
+                m_collided_left = true;
 
-                // Collision!
-                m_collided_right  = true;
-                
-            } else if (m_velocity.x < 0)
-            {
-                m_position.x    += x_overlap;
-                m_velocity.x     = 0;
- 
-                // Collision!
-                m_collided_left  = true;
-            }
+            return;
+        }
+        
+        if (m_velocity.x > 0)
+        {
+            m_position.x     -= x_overlap;
+            m_velocity.x      = 0;
+
+            // Collision!
+            m_collided_right  = true;
+            
+        } else if (m_velocity.x < 0)
+        {
+            m_position.x    += x_overlap;
+            m_velocity.x     = 0;
+
+            // Collision!
+            m_collided_left  = true;
         }
     }
 }
 
-void const Entity::check_collision_y(Map *map)
+void const Entity::check_collision_y(Entity *collidable_entities, int collidable_entity_count)
 {
-    // Probes for tiles above
-    glm::vec3 top = glm::vec3(m_position.x, m_position.y + (m_height / 2), m_position.z);
-    glm::vec3 top_left = glm::vec3(m_position.x - (m_width / 2), m_position.y + (m_height / 2), m_position.z);
-    glm::vec3 top_right = glm::vec3(m_position.x + (m_width / 2), m_position.y + (m_height / 2), m_position.z);
-    
-    // Probes for tiles below
-    glm::vec3 bottom = glm::vec3(m_position.x, m_position.y - (m_height / 2), m_position.z);
-    glm::vec3 bottom_left = glm::vec3(m_position.x - (m_width / 2), m_position.y - (m_height / 2), m_position.z);
-    glm::vec3 bottom_right = glm::vec3(m_position.x + (m_width / 2), m_position.y - (m_height / 2), m_position.z);
-    
-    float penetration_x = 0;
-    float penetration_y = 0;
-    
-    // If the map is solid, check the top three points
-    if (map->is_solid(top, &penetration_x, &penetration_y) && m_velocity.y > 0)
+    for (int i = 0; i < collidable_entity_count; i++)
     {
-        m_position.y -= penetration_y;
-        m_velocity.y = 0;
-        m_collided_top = true;
+        Entity *collidable_entity = &collidable_entities[i];
+        
+        resolve_collision_y(collidable_entity->m_position, collidable_entity->m_width, collidable_entity->m_height,
+                            collidable_entity->m_entity_type);
     }
-    else if (map->is_solid(top_left, &penetration_x, &penetration_y) && m_velocity.y > 0)
+}
+
+void const Entity::check_collision_x(Entity *collidable_entities, int collidable_entity_count)
+{
+    for (int i = 0; i < collidable_entity_count; i++)
     {
-        m_position.y -= penetration_y;
-        m_velocity.y = 0;
-        m_collided_top = true;
+        Entity *collidable_entity = &collidable_entities[i];
+        
+        resolve_collision_x(collidable_entity->m_position, collidable_entity->m_width, collidable_entity->m_height,
+                            collidable_entity->m_entity_type);
     }
-    else if (map->is_solid(top_right, &penetration_x, &penetration_y) && m_velocity.y > 0)
+}
+
+void const Entity::check_collision_y(EntityStore *collidable_entities, SpatialHash *broad_phase)
+{
+    if (broad_phase == nullptr)
     {
-        m_position.y -= penetration_y;
-        m_velocity.y = 0;
-        m_collided_top = true;
+        // Find everything we overlap in one batched pass, then resolve just those;
+        // resolve_collision_y re-tests each one against where earlier pushes left us.
+        // The batch tests in float, so the deterministic mode leaves it out.
+        bool is_batched = !Simulation::get_is_deterministic();
+        if (is_batched && !collidable_entities->overlap(m_position, m_width, m_height, m_hit_mask)) return;
+        
+        for (int i = 0; i < collidable_entities->get_count(); i++)
+        {
+            if (is_batched && !AABBBatch::is_hit(m_hit_mask, i)) continue;
+            
+            resolve_collision_y(collidable_entities->get_position(i), collidable_entities->get_width(i),
+                                collidable_entities->get_height(i), collidable_entities->get_entity_type(i));
+        }
+        return;
     }
     
-    // And the bottom three points
-    if (map->is_solid(bottom, &penetration_x, &penetration_y) && m_velocity.y < 0)
+    const std::vector<int> &candidates = broad_phase->query(m_position, m_width, m_height);
+    
+    for (size_t i = 0; i < candidates.size(); i++)
     {
-        m_position.y += penetration_y;
-        m_velocity.y = 0;
-        m_collided_bottom = true;
+        int index = candidates[i];
+        resolve_collision_y(collidable_entities->get_position(index), collidable_entities->get_width(index),
+                            collidable_entities->get_height(index), collidable_entities->get_entity_type(index));
     }
-    else if (map->is_solid(bottom_left, &penetration_x, &penetration_y) && m_velocity.y < 0)
+}
+
+void const Entity::check_collision_x(EntityStore *collidable_entities, SpatialHash *broad_phase)
+{
+    if (broad_phase == nullptr)
     {
-            m_position.y += penetration_y;
-            m_velocity.y = 0;
-            m_collided_bottom = true;
+        // Find everything we overlap in one batched pass, then resolve just those;
+        // resolve_collision_x re-tests each one against where earlier pushes left us.
+        // The batch tests in float, so the deterministic mode leaves it out.
+        bool is_batched = !Simulation::get_is_deterministic();
+        if (is_batched && !collidable_entities->overlap(m_position, m_width, m_height, m_hit_mask)) return;
+        
+        for (int i = 0; i < collidable_entities->get_count(); i++)
+        {
+            if (is_batched && !AABBBatch::is_hit(m_hit_mask, i)) continue;
+            
+            resolve_collision_x(collidable_entities->get_position(i), collidable_entities->get_width(i),
+                                collidable_entities->get_height(i), collidable_entities->get_entity_type(i));
+        }
+        return;
     }
-    else if (map->is_solid(bottom_right, &penetration_x, &penetration_y) && m_velocity.y < 0)
+    
+    const std::vector<int> &candidates = broad_phase->query(m_position, m_width, m_height);
+    
+    for (size_t i = 0; i < candidates.size(); i++)
     {
-        m_position.y += penetration_y;
-        m_velocity.y = 0;
-        m_collided_bottom = true;
-        
+        int index = candidates[i];
+        resolve_collision_x(collidable_entities->get_position(index), collidable_entities->get_width(index),
+                            collidable_entities->get_height(index), collidable_entities->get_entity_type(index));
     }
 }
 
-void const Entity::check_collision_x(Map *map)
+void const Entity::check_collision_y(Map *map, float sweep)
 {
-    // Probes for tiles; the x-checking is much simpler
-    glm::vec3 left  = glm::vec3(m_position.x - (m_width / 2), m_position.y, m_position.z);
-    glm::vec3 right = glm::vec3(m_position.x + (m_width / 2), m_position.y, m_position.z);
+    // A platform may already have stopped us
+    if (m_velocity.y == 0) return;
     
-    float penetration_x = 0;
-    float penetration_y = 0;
+    MapCollision collision = map->sweep_y(m_position, m_width, m_height, sweep);
+    if (!collision.collided) return;
     
-    if (map->is_solid(left, &penetration_x, &penetration_y) && m_velocity.x < 0)
-    {
-        m_position.x += penetration_x;
-        m_velocity.x = 0;
-        m_collided_left = true;
-    }
-    if (map->is_solid(right, &penetration_x, &penetration_y) && m_velocity.x > 0)
-    {
-        m_position.x -= penetration_x;
-        m_velocity.x = 0;
-        m_collided_right = true;
-    }
+    m_position.y += collision.correction;
+    
+    if (m_velocity.y > 0) m_collided_top    = true;
+    else                  m_collided_bottom = true;
+    
+    m_velocity.y = 0;
 }
-void Entity::update(float delta_time, Entity *player, Entity *collidable_entities, int collidable_entity_count, Map *map)
+
+void const Entity::check_collision_x(Map *map, float sweep)
 {
-    if (!m_is_active) return;
- 
+    if (m_velocity.x == 0) return;
+    
+    MapCollision collision = map->sweep_x(m_position, m_width, m_height, sweep);
+    if (!collision.collided) return;
+    
+    m_position.x += collision.correction;
+    
+    if (m_velocity.x > 0) m_collided_right = true;
+    else                  m_collided_left  = true;
+    
+    m_velocity.x = 0;
+}
+
+void Entity::begin_step(float delta_time, Entity *player)
+{
+    m_previous_position = m_position;
+    
     m_collided_top    = false;
     m_collided_bottom = false;
     m_collided_left   = false;
@@ -377,32 +465,103 @@ void Entity::update(float delta_time, Entity *player, Entity *collidable_entitie
         }
     }
     
-    m_velocity.x = m_movement.x * m_speed;
-    m_velocity += m_acceleration * delta_time;
+    if (Simulation::get_is_deterministic())
+    {
+        fixed_t step       = FixedPoint::from_float(delta_time),
+                velocity_x = FixedPoint::mul(FixedPoint::from_float(m_movement.x), FixedPoint::from_float(m_speed)),
+                velocity_y = FixedPoint::from_float(m_velocity.y);
+        
+        velocity_x += FixedPoint::mul(FixedPoint::from_float(m_acceleration.x), step);
+        velocity_y += FixedPoint::mul(FixedPoint::from_float(m_acceleration.y), step);
+        
+        m_velocity.x = FixedPoint::to_float(velocity_x);
+        m_velocity.y = FixedPoint::to_float(velocity_y);
+    }
+    else
+    {
+        m_velocity.x = m_movement.x * m_speed;
+        m_velocity += m_acceleration * delta_time;
+    }
     
     if (m_is_jumping)
     {
         m_is_jumping = false;
         m_velocity.y += m_jumping_power;
     }
+}
+
+float Entity::integrate(float &position, float velocity, float delta_time)
+{
+    if (Simulation::get_is_deterministic())
+    {
+        fixed_t sweep = FixedPoint::mul(FixedPoint::from_float(velocity), FixedPoint::from_float(delta_time));
+        
+        position = FixedPoint::to_float(FixedPoint::from_float(position) + sweep);
+        return FixedPoint::to_float(sweep);
+    }
     
-    m_position.y += m_velocity.y * delta_time;
+    float sweep = velocity * delta_time;
+    position += sweep;
+    return sweep;
+}
+
+void Entity::end_step()
+{
+    m_model_matrix = glm::mat4(1.0f);
+    m_model_matrix = glm::translate(m_model_matrix, m_position);
+}
+
+void Entity::update(float delta_time, Entity *player, Entity *collidable_entities, int collidable_entity_count, Map *map)
+{
+    if (!m_is_active) return;
+    
+    PROFILE_SCOPE("entity update");
+    
+    begin_step(delta_time, player);
+    
+    float sweep_y = integrate(m_position.y, m_velocity.y, delta_time);
     
     check_collision_y(collidable_entities, collidable_entity_count);
-    check_collision_y(map);
+    check_collision_y(map, sweep_y);
     
-    m_position.x += m_velocity.x * delta_time;
+    float sweep_x = integrate(m_position.x, m_velocity.x, delta_time);
     check_collision_x(collidable_entities, collidable_entity_count);
-    check_collision_x(map);
+    check_collision_x(map, sweep_x);
     
-    m_model_matrix = glm::mat4(1.0f);
-    m_model_matrix = glm::translate(m_model_matrix, m_position);
+    end_step();
+}
+
+void Entity::update(float delta_time, Entity *player, EntityStore *collidable_entities, Map *map, SpatialHash *broad_phase)
+{
+    if (!m_is_active) return;
+    
+    PROFILE_SCOPE("entity update");
+    
+    begin_step(delta_time, player);
+    
+    float sweep_y = integrate(m_position.y, m_velocity.y, delta_time);
+    
+    check_collision_y(collidable_entities, broad_phase);
+    check_collision_y(map, sweep_y);
+    
+    float sweep_x = integrate(m_position.x, m_velocity.x, delta_time);
+    check_collision_x(collidable_entities, broad_phase);
+    check_collision_x(map, sweep_x);
+    
+    end_step();
 }
 
 
-void Entity::render(ShaderProgram* program)
+glm::mat4 const Entity::get_model_matrix(float alpha) const
 {
-    program->set_model_matrix(m_model_matrix);
+    if (alpha >= 1.0f) return m_model_matrix;
+    
+    return glm::translate(glm::mat4(1.0f), get_position(alpha));
+}
+
+void Entity::render(ShaderProgram* program, float alpha)
+{
+    program->set_model_matrix(get_model_matrix(alpha));
 
     if (m_animation_indices != NULL)
     {
@@ -410,8 +569,13 @@ void Entity::render(ShaderProgram* program)
         return;
     }
 
+    float left   = m_atlas_region.u,
+          right  = m_atlas_region.u + m_atlas_region.width,
+          top    = m_atlas_region.v,
+          bottom = m_atlas_region.v + m_atlas_region.height;
+    
     float vertices[] = { -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, -0.5, 0.5, 0.5, -0.5, 0.5 };
-    float tex_coords[] = { 0.0,  1.0, 1.0,  1.0, 1.0, 0.0,  0.0,  1.0, 1.0, 0.0,  0.0, 0.0 };
+    float tex_coords[] = { left, bottom, right, bottom, right, top, left, bottom, right, top, left, top };
 
     glBindTexture(GL_TEXTURE_2D, m_texture_id);
 
@@ -425,3 +589,22 @@ void Entity::render(ShaderProgram* program)
     glDisableVertexAttribArray(program->get_position_attribute());
     glDisableVertexAttribArray(program->get_tex_coordinate_attribute());
 }
+
+void Entity::render(SpriteBatch* batch, float alpha)
+{
+    glm::mat4 model_matrix = get_model_matrix(alpha);
+    
+    if (m_animation_indices != NULL)
+    {
+        int index = m_animation_indices[m_animation_index];
+        
+        float u_coord = m_atlas_region.map_u((float)(index % m_animation_cols) / (float)m_animation_cols);
+        float v_coord = m_atlas_region.map_v((float)(index / m_animation_cols) / (float)m_animation_rows);
+        
+        batch->draw(m_texture_id, model_matrix, u_coord, v_coord,
+                    m_atlas_region.width / (float)m_animation_cols, m_atlas_region.height / (float)m_animation_rows);
+        return;
+    }
+    
+    batch->draw(m_texture_id, model_matrix, m_atlas_region.u, m_atlas_region.v, m_atlas_region.width, m_atlas_region.height);
+}
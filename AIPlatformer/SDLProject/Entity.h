@@ -4,6 +4,12 @@
 #include "Map.h"
 #include "glm/glm.hpp"
 #include "ShaderProgram.h"
+#include "SpriteBatch.h"
+#include "TextureAtlas.h"
+#include "SpatialHash.h"
+#include "AABBBatch.h"
+
+class EntityStore;
 enum EntityType { PLATFORM, PLAYER, ENEMY  };
 enum AIType     { WALKER, GUARD, PATROL            };
 enum AIState    { WALKING, IDLE, ATTACKING };
@@ -28,16 +34,23 @@ private:
     glm::vec3 m_scale;
     glm::vec3 m_velocity;
     glm::vec3 m_acceleration;
+    
+    // Where the last step started from, so a frame can be drawn part way between steps
+    glm::vec3 m_previous_position = glm::vec3(0.0f);
 
     glm::mat4 m_model_matrix;
 
     float     m_speed,
               m_jumping_power;
     
-    bool m_is_jumping;
+    bool m_is_jumping = false;
 
     // ————— TEXTURES ————— //
     GLuint    m_texture_id;
+    
+    // The part of m_texture_id this entity's sprite sheet takes up, if it was packed
+    // into an atlas; animation frames are cut out of this rather than the whole texture
+    AtlasRegion m_atlas_region;
 
     // ————— ANIMATION ————— //
     int m_animation_cols;
@@ -56,7 +69,19 @@ private:
     bool m_collided_left   = false;
     bool m_collided_right  = false;
     
+    // Scratch space for batched overlap tests against an EntityStore
+    std::vector<uint64_t> m_hit_mask;
+    
     int lives = 3;
+    
+    void const resolve_collision_y(glm::vec3 other_position, float other_width, float other_height, EntityType other_type);
+    void const resolve_collision_x(glm::vec3 other_position, float other_width, float other_height, EntityType other_type);
+    
+    void begin_step(float delta_time, Entity *player);
+    void end_step();
+    
+    // Moves position on by velocity for one step and returns how far that was
+    float integrate(float &position, float velocity, float delta_time);
 
 public:
     // ————— STATIC VARIABLES ————— //
@@ -65,10 +90,12 @@ public:
     // ————— METHODS ————— //
     
     bool check_collision_with_enemies(Entity* enemies, int enemy_count);
+    bool check_collision_with_enemies(EntityStore* enemies, SpatialHash *broad_phase);
 
     
     int get_lives() const { return lives; }
     void lose_life() { if (lives > 0) lives--; }
+    void set_lives(int new_lives) { lives = new_lives; }
     
     Entity();
     Entity(GLuint texture_id, float speed, glm::vec3 acceleration, float jump_power, int walking[4][4], float animation_time,
@@ -80,16 +107,29 @@ public:
 
     void draw_sprite_from_texture_atlas(ShaderProgram* program, GLuint texture_id, int index);
     bool const check_collision(Entity* other) const;
+    bool const check_collision(glm::vec3 other_position, float other_width, float other_height) const;
     
     void const check_collision_y(Entity* collidable_entities, int collidable_entity_count);
     void const check_collision_x(Entity* collidable_entities, int collidable_entity_count);
     
-    // Overloading our methods to check for only the map
-    void const check_collision_y(Map *map);
-    void const check_collision_x(Map *map);
+    // Same as above, but against a store; with a broad phase only the entities it puts
+    // near us are checked
+    void const check_collision_y(EntityStore* collidable_entities, SpatialHash *broad_phase);
+    void const check_collision_x(EntityStore* collidable_entities, SpatialHash *broad_phase);
+    
+    // Overloading our methods to check for only the map; sweep is how far we moved on
+    // that axis this step
+    void const check_collision_y(Map *map, float sweep);
+    void const check_collision_x(Map *map, float sweep);
     
     void update(float delta_time, Entity *player, Entity *collidable_entities, int collidable_entity_count, Map *map);
-    void render(ShaderProgram* program);
+    void update(float delta_time, Entity *player, EntityStore *collidable_entities, Map *map,
+                SpatialHash *broad_phase = nullptr);
+    // alpha = 1 draws where the last step left us; less draws that far along from where
+    // it started
+    void render(ShaderProgram* program, float alpha = 1.0f);
+    void render(SpriteBatch* batch, float alpha = 1.0f);
+    glm::mat4 const get_model_matrix(float alpha) const;
 
     void ai_activate(Entity *player);
     void ai_walk();
@@ -117,6 +157,7 @@ public:
     AIState    const get_ai_state()       const { return m_ai_state;      };
     float const get_jumping_power() const { return m_jumping_power; }
     glm::vec3 const get_position()     const { return m_position; }
+    glm::vec3 const get_position(float alpha) const { return glm::mix(m_previous_position, m_position, alpha); }
     glm::vec3 const get_velocity()     const { return m_velocity; }
     glm::vec3 const get_acceleration() const { return m_acceleration; }
     glm::vec3 const get_movement()     const { return m_movement; }
@@ -127,6 +168,9 @@ public:
     bool      const get_collided_bottom() const { return m_collided_bottom; }
     bool      const get_collided_right() const { return m_collided_right; }
     bool      const get_collided_left() const { return m_collided_left; }
+    bool      const get_is_active()    const { return m_is_active; }
+    float     const get_width()        const { return m_width; }
+    float     const get_height()       const { return m_height; }
     
     void activate()   { m_is_active = true;  };
     void deactivate() { m_is_active = false; };
@@ -134,12 +178,14 @@ public:
     void const set_entity_type(EntityType new_entity_type)  { m_entity_type = new_entity_type;};
     void const set_ai_type(AIType new_ai_type){ m_ai_type = new_ai_type;};
     void const set_ai_state(AIState new_state){ m_ai_state = new_state;};
-    void const set_position(glm::vec3 new_position) { m_position = new_position; }
+    // Moving an entity by hand is a jump, not something to draw it sliding across
+    void const set_position(glm::vec3 new_position) { m_position = m_previous_position = new_position; }
     void const set_velocity(glm::vec3 new_velocity) { m_velocity = new_velocity; }
     void const set_acceleration(glm::vec3 new_acceleration) { m_acceleration = new_acceleration; }
     void const set_movement(glm::vec3 new_movement) { m_movement = new_movement; }
     void const set_scale(glm::vec3 new_scale) { m_scale = new_scale; }
     void const set_texture_id(GLuint new_texture_id) { m_texture_id = new_texture_id; }
+    void const set_atlas_region(const AtlasRegion &new_region) { m_atlas_region = new_region; }
     void const set_speed(float new_speed) { m_speed = new_speed; }
     void const set_animation_cols(int new_cols) { m_animation_cols = new_cols; }
     void const set_animation_rows(int new_rows) { m_animation_rows = new_rows; }
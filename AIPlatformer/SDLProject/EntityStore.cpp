@@ -0,0 +1,277 @@
+#define SPAWN_SPEED   1.0f
+#define SPAWN_WIDTH   1.0f
+#define SPAWN_HEIGHT  1.0f
+#define SPAWN_GRAVITY -9.81f
+#define UPDATE_GRAIN  2048    // entities per job; fewer than two jobs' worth step on the caller
+
+#include "EntityStore.h"
+#include "Simulation.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include "glm/gtc/matrix_transform.hpp"
+
+void EntityStore::reserve(int capacity)
+{
+    m_position_x.reserve(capacity);     m_position_y.reserve(capacity);
+    m_velocity_x.reserve(capacity);     m_velocity_y.reserve(capacity);
+    m_acceleration_x.reserve(capacity); m_acceleration_y.reserve(capacity);
+    m_movement_x.reserve(capacity);     m_speed.reserve(capacity);
+    m_previous_x.reserve(capacity);     m_previous_y.reserve(capacity);
+    m_sweep.reserve(capacity);
+    m_width.reserve(capacity);          m_height.reserve(capacity);
+    m_flags.reserve(capacity);
+    m_entity_type.reserve(capacity);    m_ai_type.reserve(capacity);
+    m_ai_state.reserve(capacity);       m_texture_id.reserve(capacity);
+}
+
+int EntityStore::add(const Entity &entity)
+{
+    m_position_x.push_back(entity.get_position().x);
+    m_position_y.push_back(entity.get_position().y);
+    m_velocity_x.push_back(entity.get_velocity().x);
+    m_velocity_y.push_back(entity.get_velocity().y);
+    m_acceleration_x.push_back(entity.get_acceleration().x);
+    m_acceleration_y.push_back(entity.get_acceleration().y);
+    m_movement_x.push_back(entity.get_movement().x);
+    m_speed.push_back(entity.get_speed());
+    m_previous_x.push_back(entity.get_position().x);
+    m_previous_y.push_back(entity.get_position().y);
+    m_sweep.push_back(0.0f);
+    
+    m_width.push_back(entity.get_width());
+    m_height.push_back(entity.get_height());
+    m_flags.push_back(entity.get_is_active() ? ACTIVE : 0);
+    
+    m_entity_type.push_back(entity.get_entity_type());
+    m_ai_type.push_back(entity.get_ai_type());
+    m_ai_state.push_back(entity.get_ai_state());
+    m_texture_id.push_back(entity.get_texture_id());
+    
+    return m_count++;
+}
+
+void EntityStore::spawn(const LevelFile &level, GLuint texture_id)
+{
+    reserve(m_count + level.get_enemy_count());
+    
+    for (int i = 0; i < level.get_enemy_count(); i++)
+    {
+        const LevelEnemySpawn &spawn = level.get_enemy(i);
+        
+        int enemy = add(Entity(texture_id, SPAWN_SPEED, SPAWN_WIDTH, SPAWN_HEIGHT, ENEMY,
+                               (AIType) spawn.ai_type, (AIState) spawn.ai_state));
+        
+        set_position(enemy, glm::vec3(spawn.x, spawn.y, 0.0f));
+        set_movement(enemy, glm::vec3(0.0f));
+        set_acceleration(enemy, glm::vec3(0.0f, SPAWN_GRAVITY, 0.0f));
+    }
+}
+
+// ————— KERNELS ————— //
+void EntityStore::ai_kernel(glm::vec3 player_position, int begin, int end)
+{
+    for (int i = begin; i < end; i++)
+    {
+        if (!(m_flags[i] & ACTIVE) || m_entity_type[i] != ENEMY) continue;
+        
+        switch (m_ai_type[i])
+        {
+            case WALKER:
+                m_movement_x[i] = -1.0f;
+                break;
+                
+            case GUARD:
+                if (m_ai_state[i] == IDLE && Simulation::get_is_deterministic())
+                {
+                    fixed_t x_distance = FixedPoint::from_float(m_position_x[i]) - FixedPoint::from_float(player_position.x),
+                            y_distance = FixedPoint::from_float(m_position_y[i]) - FixedPoint::from_float(player_position.y);
+                    
+                    if (FixedPoint::mul(x_distance, x_distance) + FixedPoint::mul(y_distance, y_distance) < FixedPoint::from_int(3 * 3))
+                        m_ai_state[i] = WALKING;
+                }
+                else if (m_ai_state[i] == IDLE)
+                {
+                    float x_distance = m_position_x[i] - player_position.x,
+                          y_distance = m_position_y[i] - player_position.y;
+                    
+                    if (x_distance * x_distance + y_distance * y_distance < 3.0f * 3.0f) m_ai_state[i] = WALKING;
+                }
+                else if (m_ai_state[i] == WALKING)
+                {
+                    m_movement_x[i] = m_position_x[i] > player_position.x ? -1.0f : 1.0f;
+                }
+                break;
+                
+            case PATROL:
+                if (m_position_x[i] < 1.5f)
+                    m_movement_x[i] = 5.0f;
+                else if (m_position_x[i] > 11.5f)
+                    m_movement_x[i] = -5.0f;
+                break;
+                
+            default:
+                break;
+        }
+    }
+}
+
+void EntityStore::velocity_kernel(float delta_time, int begin, int end)
+{
+    if (Simulation::get_is_deterministic())
+    {
+        velocity_kernel_fixed(delta_time, begin, end);
+        return;
+    }
+    
+    for (int i = begin; i < end; i++)
+    {
+        if (!(m_flags[i] & ACTIVE)) continue;
+        
+        m_flags[i] &= ~COLLIDED_ANY;
+        
+        m_velocity_x[i]  = m_movement_x[i] * m_speed[i];
+        m_velocity_x[i] += m_acceleration_x[i] * delta_time;
+        m_velocity_y[i] += m_acceleration_y[i] * delta_time;
+    }
+}
+
+void EntityStore::integrate_y_kernel(float delta_time, int begin, int end)
+{
+    if (Simulation::get_is_deterministic())
+    {
+        integrate_kernel_fixed(m_position_y, m_velocity_y, delta_time, begin, end);
+        return;
+    }
+    
+    for (int i = begin; i < end; i++)
+    {
+        m_sweep[i] = (m_flags[i] & ACTIVE) ? m_velocity_y[i] * delta_time : 0.0f;
+        m_position_y[i] += m_sweep[i];
+    }
+}
+
+void EntityStore::integrate_x_kernel(float delta_time, int begin, int end)
+{
+    if (Simulation::get_is_deterministic())
+    {
+        integrate_kernel_fixed(m_position_x, m_velocity_x, delta_time, begin, end);
+        return;
+    }
+    
+    for (int i = begin; i < end; i++)
+    {
+        m_sweep[i] = (m_flags[i] & ACTIVE) ? m_velocity_x[i] * delta_time : 0.0f;
+        m_position_x[i] += m_sweep[i];
+    }
+}
+
+// The deterministic mode's versions of the two above, in FixedPoint
+void EntityStore::velocity_kernel_fixed(float delta_time, int begin, int end)
+{
+    fixed_t step = FixedPoint::from_float(delta_time);
+    
+    for (int i = begin; i < end; i++)
+    {
+        if (!(m_flags[i] & ACTIVE)) continue;
+        
+        m_flags[i] &= ~COLLIDED_ANY;
+        
+        fixed_t velocity_x = FixedPoint::mul(FixedPoint::from_float(m_movement_x[i]), FixedPoint::from_float(m_speed[i])) +
+                             FixedPoint::mul(FixedPoint::from_float(m_acceleration_x[i]), step),
+                velocity_y = FixedPoint::from_float(m_velocity_y[i]) +
+                             FixedPoint::mul(FixedPoint::from_float(m_acceleration_y[i]), step);
+        
+        m_velocity_x[i] = FixedPoint::to_float(velocity_x);
+        m_velocity_y[i] = FixedPoint::to_float(velocity_y);
+    }
+}
+
+void EntityStore::integrate_kernel_fixed(std::vector<float> &positions, const std::vector<float> &velocities, float delta_time,
+                                         int begin, int end)
+{
+    fixed_t step = FixedPoint::from_float(delta_time);
+    
+    for (int i = begin; i < end; i++)
+    {
+        fixed_t sweep = (m_flags[i] & ACTIVE) ? FixedPoint::mul(FixedPoint::from_float(velocities[i]), step) : 0;
+        
+        m_sweep[i]   = FixedPoint::to_float(sweep);
+        positions[i] = FixedPoint::to_float(FixedPoint::from_float(positions[i]) + sweep);
+    }
+}
+
+void EntityStore::collide_map_y_kernel(Map *map, int begin, int end)
+{
+    for (int i = begin; i < end; i++)
+    {
+        // Inactive entities never moved, so their sweep is zero too
+        if (m_sweep[i] == 0.0f || m_velocity_y[i] == 0.0f) continue;
+        
+        MapCollision collision = map->sweep_y(glm::vec3(m_position_x[i], m_position_y[i], 0.0f),
+                                              m_width[i], m_height[i], m_sweep[i]);
+        if (!collision.collided) continue;
+        
+        m_position_y[i] += collision.correction;
+        m_flags[i]      |= m_velocity_y[i] > 0 ? COLLIDED_TOP : COLLIDED_BOTTOM;
+        m_velocity_y[i]  = 0.0f;
+    }
+}
+
+void EntityStore::collide_map_x_kernel(Map *map, int begin, int end)
+{
+    for (int i = begin; i < end; i++)
+    {
+        if (m_sweep[i] == 0.0f || m_velocity_x[i] == 0.0f) continue;
+        
+        MapCollision collision = map->sweep_x(glm::vec3(m_position_x[i], m_position_y[i], 0.0f),
+                                              m_width[i], m_height[i], m_sweep[i]);
+        if (!collision.collided) continue;
+        
+        m_position_x[i] += collision.correction;
+        m_flags[i]      |= m_velocity_x[i] > 0 ? COLLIDED_RIGHT : COLLIDED_LEFT;
+        m_velocity_x[i]  = 0.0f;
+    }
+}
+
+// ————— METHODS ————— //
+void EntityStore::update(float delta_time, Entity *player, Map *map)
+{
+    PROFILE_SCOPE("enemy update");
+    
+    glm::vec3 player_position = player->get_position();
+    
+    // Nothing here reads another entity in the store, and the map is only read, so the
+    // store can be split into ranges that step on their own; each range runs the whole
+    // pipeline while its entities are still in cache
+    JobSystem::parallel_for(m_count, UPDATE_GRAIN, [&](int begin, int end)
+    {
+        update_range(delta_time, player_position, map, begin, end);
+    });
+}
+
+void EntityStore::update_range(float delta_time, glm::vec3 player_position, Map *map, int begin, int end)
+{
+    // Same order as Entity::update: think, accelerate, then move and collide one axis
+    // at a time. The entities in a store don't collide with each other.
+    std::copy(m_position_x.begin() + begin, m_position_x.begin() + end, m_previous_x.begin() + begin);
+    std::copy(m_position_y.begin() + begin, m_position_y.begin() + end, m_previous_y.begin() + begin);
+    
+    ai_kernel(player_position, begin, end);
+    velocity_kernel(delta_time, begin, end);
+    
+    integrate_y_kernel(delta_time, begin, end);
+    collide_map_y_kernel(map, begin, end);
+    
+    integrate_x_kernel(delta_time, begin, end);
+    collide_map_x_kernel(map, begin, end);
+}
+
+void EntityStore::render(InstanceBatch *batch, float alpha) const
+{
+    for (int i = 0; i < m_count; i++)
+    {
+        batch->draw(m_previous_x[i] + (m_position_x[i] - m_previous_x[i]) * alpha,
+                    m_previous_y[i] + (m_position_y[i] - m_previous_y[i]) * alpha);
+    }
+}
@@ -0,0 +1,135 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <vector>
+#include <SDL_opengl.h>
+#include "glm/glm.hpp"
+#include "Entity.h"
+#include "Map.h"
+#include "SpriteBatch.h"
+#include "InstanceBatch.h"
+#include "AABBBatch.h"
+#include "LevelFile.h"
+
+/**
+    Structure-of-arrays storage for the physics side of many simple entities (the
+    enemies). Each field lives in its own contiguous array and the step runs as a
+    handful of kernels over those arrays instead of one fat Entity::update per enemy.
+    Scene code refers to an entity by the index add() returned.
+*/
+class EntityStore
+{
+private:
+    int m_count = 0;
+    
+    // ————— TRANSFORMATIONS ————— //
+    std::vector<float> m_position_x,     m_position_y;
+    std::vector<float> m_velocity_x,     m_velocity_y;
+    std::vector<float> m_acceleration_x, m_acceleration_y;
+    std::vector<float> m_movement_x;
+    std::vector<float> m_speed;
+    
+    // Positions as the last step started, for drawing between steps
+    std::vector<float> m_previous_x, m_previous_y;
+    
+    // How far each entity moved this step on the axis being resolved
+    std::vector<float> m_sweep;
+    
+    // ————— COLLISIONS ————— //
+    std::vector<float>         m_width, m_height;
+    std::vector<unsigned char> m_flags;
+    
+    // ————— AI ————— //
+    std::vector<unsigned char> m_entity_type, m_ai_type, m_ai_state;
+    
+    // ————— TEXTURES ————— //
+    std::vector<GLuint> m_texture_id;
+    
+    // ————— KERNELS ————— //
+    // Each works on the entities in [begin, end) and touches no others
+    void ai_kernel(glm::vec3 player_position, int begin, int end);
+    void velocity_kernel(float delta_time, int begin, int end);
+    void integrate_y_kernel(float delta_time, int begin, int end);
+    void integrate_x_kernel(float delta_time, int begin, int end);
+    void velocity_kernel_fixed(float delta_time, int begin, int end);
+    void integrate_kernel_fixed(std::vector<float> &positions, const std::vector<float> &velocities, float delta_time,
+                                int begin, int end);
+    void collide_map_y_kernel(Map *map, int begin, int end);
+    void collide_map_x_kernel(Map *map, int begin, int end);
+    
+    void update_range(float delta_time, glm::vec3 player_position, Map *map, int begin, int end);
+    
+public:
+    // ————— STATIC VARIABLES ————— //
+    static constexpr unsigned char ACTIVE          = 1 << 0,
+                                   COLLIDED_TOP    = 1 << 1,
+                                   COLLIDED_BOTTOM = 1 << 2,
+                                   COLLIDED_LEFT   = 1 << 3,
+                                   COLLIDED_RIGHT  = 1 << 4,
+                                   COLLIDED_ANY    = COLLIDED_TOP | COLLIDED_BOTTOM | COLLIDED_LEFT | COLLIDED_RIGHT;
+    
+    // ————— METHODS ————— //
+    void reserve(int capacity);
+    int  add(const Entity &entity);
+    
+    // Adds one enemy per spawn record in the level, in file order
+    void spawn(const LevelFile &level, GLuint texture_id);
+    
+    // Steps every entity, spread over the JobSystem's threads when there are enough of
+    // them; the result is the same however it was split
+    void update(float delta_time, Entity *player, Map *map);
+    // Just the positions; the batch was begun with the texture (or atlas region) they share
+    void render(InstanceBatch *batch, float alpha = 1.0f) const;
+    
+    // Sets bit i of hit_mask for every entity i overlapping the box; see AABBBatch
+    bool overlap(glm::vec3 position, float width, float height, std::vector<uint64_t> &hit_mask) const
+    {
+        return AABBBatch::overlap(position.x, position.y, width, height, m_position_x.data(), m_position_y.data(),
+                                  m_width.data(), m_height.data(), m_count, hit_mask);
+    }
+    
+    // ————— GETTERS ————— //
+    int const get_count() const { return m_count; }
+    
+    glm::vec3  const get_position(int index) const { return glm::vec3(m_position_x[index], m_position_y[index], 0.0f); }
+    glm::vec3  const get_velocity(int index) const { return glm::vec3(m_velocity_x[index], m_velocity_y[index], 0.0f); }
+    float      const get_width(int index)    const { return m_width[index];  }
+    float      const get_height(int index)   const { return m_height[index]; }
+    EntityType const get_entity_type(int index) const { return (EntityType) m_entity_type[index]; }
+    AIState    const get_ai_state(int index)    const { return (AIState) m_ai_state[index];       }
+    bool       const get_is_active(int index)   const { return m_flags[index] & ACTIVE;           }
+    bool       const get_collided_bottom(int index) const { return m_flags[index] & COLLIDED_BOTTOM; }
+    
+    // The raw arrays, for code that wants to sweep over every entity itself
+    const float *get_positions_x() const { return m_position_x.data(); }
+    const float *get_positions_y() const { return m_position_y.data(); }
+    const float *get_widths()      const { return m_width.data();      }
+    const float *get_heights()     const { return m_height.data();     }
+    
+    // ————— SETTERS ————— //
+    void const set_position(int index, glm::vec3 new_position)
+    {
+        m_position_x[index] = m_previous_x[index] = new_position.x;
+        m_position_y[index] = m_previous_y[index] = new_position.y;
+    }
+    void const set_velocity(int index, glm::vec3 new_velocity)
+    {
+        m_velocity_x[index] = new_velocity.x;
+        m_velocity_y[index] = new_velocity.y;
+    }
+    void const set_acceleration(int index, glm::vec3 new_acceleration)
+    {
+        m_acceleration_x[index] = new_acceleration.x;
+        m_acceleration_y[index] = new_acceleration.y;
+    }
+    void const set_movement(int index, glm::vec3 new_movement) { m_movement_x[index] = new_movement.x; }
+    void const set_ai_state(int index, AIState new_state)      { m_ai_state[index] = new_state;        }
+    
+    void activate(int index)   { m_flags[index] |=  ACTIVE; }
+    void deactivate(int index) { m_flags[index] &= ~ACTIVE; }
+};
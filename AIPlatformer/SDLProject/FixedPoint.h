@@ -0,0 +1,41 @@
+#pragma once
+#include <stdint.h>
+#include <cmath>
+
+/**
+    16.16 fixed-point numbers, kept in 64 bits so products don't overflow, for the
+    deterministic simulation mode (see Simulation.h). Integer adds, multiplies and
+    divides come out the same on every compiler and at every optimisation level; float
+    ones needn't, because a compiler may fuse a multiply and the add after it into one
+    FMA, which rounds once instead of twice.
+    
+    Converting to float and back is exact for values on the 1/65536 grid smaller than
+    256, which covers the levels we ship, and correctly rounded (so still the same
+    everywhere) outside that.
+*/
+typedef int64_t fixed_t;
+
+class FixedPoint
+{
+public:
+    // ————— STATIC VARIABLES ————— //
+    static constexpr int     FRACTION_BITS = 16;
+    static constexpr fixed_t ONE           = (fixed_t) 1 << FRACTION_BITS;
+    
+    // ————— METHODS ————— //
+    static fixed_t const from_float(float value) { return (fixed_t) std::llround((double) value * ONE); }
+    static fixed_t const from_int(int value)     { return (fixed_t) value * ONE;                       }
+    static float   const to_float(fixed_t value) { return (float) ((double) value / ONE);               }
+    
+    // Both round towards zero, like integer division
+    static fixed_t const mul(fixed_t a, fixed_t b) { return a * b / ONE; }
+    static fixed_t const div(fixed_t a, fixed_t b) { return a * ONE / b; }
+    
+    static fixed_t const abs(fixed_t value) { return value < 0 ? -value : value; }
+    
+    // Which whole multiple of divisor (> 0) value falls in, rounding down for negatives too
+    static int const floor_div(fixed_t value, fixed_t divisor)
+    {
+        return (int) (value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor));
+    }
+};
@@ -0,0 +1,194 @@
+#define RANGES_PER_THREAD 4   // at most this many ranges per thread, so thieves have something to take
+
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Job
+{
+    const JobSystem::RangeJob *job;
+    int                        begin, end;
+    std::atomic<int>          *remaining;
+};
+
+struct JobQueue
+{
+    std::mutex      mutex;
+    std::deque<Job> jobs;
+};
+
+// Queue 0 belongs to the thread that calls parallel_for(); worker i has queue i + 1
+static std::vector<std::unique_ptr<JobQueue>> g_queues;
+static std::vector<std::thread>               g_workers;
+
+// Jobs sitting in any queue; idle workers sleep until there are some
+static std::atomic<int>        g_queued(0);
+static std::mutex              g_wake_mutex;
+static std::condition_variable g_wake;
+static bool                    g_is_stopping = false;
+
+static std::atomic<uint64_t> g_batches(0),
+                             g_jobs(0),
+                             g_steals(0);
+
+// ————— QUEUES ————— //
+static bool pop_own(int queue, Job &job)
+{
+    JobQueue &own = *g_queues[queue];
+    std::lock_guard<std::mutex> lock(own.mutex);
+
+    if (own.jobs.empty()) return false;
+
+    job = own.jobs.back();
+    own.jobs.pop_back();
+    return true;
+}
+
+static bool steal(int thief, Job &job)
+{
+    int queue_count = (int) g_queues.size();
+
+    // Start from the next queue along, so thieves don't all pile onto the same victim
+    for (int offset = 1; offset < queue_count; offset++)
+    {
+        JobQueue &victim = *g_queues[(thief + offset) % queue_count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+
+        if (victim.jobs.empty()) continue;
+
+        job = victim.jobs.front();
+        victim.jobs.pop_front();
+        g_steals++;
+        return true;
+    }
+
+    return false;
+}
+
+static bool find_job(int queue, Job &job)
+{
+    if (!pop_own(queue, job) && !steal(queue, job)) return false;
+
+    g_queued--;
+    return true;
+}
+
+static void run(const Job &job)
+{
+    (*job.job)(job.begin, job.end);
+    g_jobs++;
+
+    // Release, so the caller sees everything the job wrote once it sees the count drop
+    job.remaining->fetch_sub(1, std::memory_order_release);
+}
+
+static void work(int queue)
+{
+    while (true)
+    {
+        Job job;
+        if (find_job(queue, job))
+        {
+            run(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(g_wake_mutex);
+        g_wake.wait(lock, [] { return g_is_stopping || g_queued > 0; });
+
+        if (g_is_stopping) return;
+    }
+}
+
+// ————— METHODS ————— //
+void JobSystem::start(int worker_count)
+{
+    if (!g_workers.empty()) return;
+
+    if (worker_count < 0) worker_count = (int) std::thread::hardware_concurrency() - 1;
+    if (worker_count <= 0) return;
+
+    g_is_stopping = false;
+
+    for (int i = 0; i <= worker_count; i++) g_queues.emplace_back(new JobQueue());
+    for (int i = 1; i <= worker_count; i++) g_workers.emplace_back(work, i);
+}
+
+void JobSystem::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(g_wake_mutex);
+        g_is_stopping = true;
+    }
+    g_wake.notify_all();
+
+    for (std::thread &worker : g_workers) worker.join();
+
+    g_workers.clear();
+    g_queues.clear();
+}
+
+void JobSystem::parallel_for(int count, int grain, const RangeJob &job)
+{
+    grain = std::max(grain, 1);
+
+    if (g_workers.empty() || count < grain * 2)
+    {
+        if (count > 0) job(0, count);
+        return;
+    }
+
+    // Ranges of at least grain items, but never so many that queueing them costs more
+    // than the work in them
+    int thread_count = (int) g_queues.size(),
+        range_count  = std::min((count + grain - 1) / grain, thread_count * RANGES_PER_THREAD),
+        range_size   = (count + range_count - 1) / range_count;
+
+    range_count = (count + range_size - 1) / range_size;
+
+    std::atomic<int> remaining(range_count);
+
+    for (int range = 0; range < range_count; range++)
+    {
+        Job queued = { &job, range * range_size, std::min((range + 1) * range_size, count), &remaining };
+
+        JobQueue &queue = *g_queues[range % thread_count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(queued);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_wake_mutex);
+        g_queued += range_count;
+    }
+    g_wake.notify_all();
+    g_batches++;
+
+    // Help out until the last range is handed out, then wait for the ones still running
+    Job own;
+    while (find_job(0, own)) run(own);
+
+    while (remaining.load(std::memory_order_acquire) > 0) std::this_thread::yield();
+}
+
+// ————— GETTERS ————— //
+int const JobSystem::get_worker_count()
+{
+    return (int) g_workers.size();
+}
+
+JobStats const JobSystem::get_stats()
+{
+    JobStats stats;
+    stats.batches = g_batches;
+    stats.jobs    = g_jobs;
+    stats.steals  = g_steals;
+
+    return stats;
+}
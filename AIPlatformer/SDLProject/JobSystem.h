@@ -0,0 +1,44 @@
+#pragma once
+#include <functional>
+#include <stdint.h>
+
+struct JobStats
+{
+    uint64_t batches = 0,     // parallel_for() calls that went out to the workers
+             jobs    = 0,     // ranges run, on any thread
+             steals  = 0;     // ranges a thread took from another's queue
+};
+
+/**
+    A fixed pool of worker threads for data-parallel loops over the simulation.
+
+    parallel_for() cuts [0, count) into ranges of about grain items and deals them out
+    round-robin to one queue per thread, the calling thread included. Every thread works
+    from the back of its own queue and, once that's empty, steals from the front of the
+    others', so a range that turns out slow doesn't hold the rest up. The caller helps
+    until every range is done, so the call returns with all of the work finished.
+
+    The job must only write to the items in its range; anything that depends on several
+    of them (an entity hitting another) belongs after the call, in one thread. Then the
+    result doesn't depend on how many threads there are or who ran which range.
+
+    Only one thread (the main one) may call parallel_for(), and not from inside a job.
+    Until start() is called, or for less than two ranges' worth of items, the job just
+    runs on the caller.
+*/
+class JobSystem
+{
+public:
+    typedef std::function<void(int begin, int end)> RangeJob;
+
+    // ————— METHODS ————— //
+    // worker_count threads besides the caller; negative means one per remaining core
+    static void start(int worker_count = -1);
+    static void stop();
+
+    static void parallel_for(int count, int grain, const RangeJob &job);
+
+    // ————— GETTERS ————— //
+    static int      const get_worker_count();
+    static JobStats const get_stats();
+};
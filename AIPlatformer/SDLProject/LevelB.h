@@ -2,16 +2,14 @@
 
 class LevelB : public Scene {
 public:
-    // ————— STATIC ATTRIBUTES ————— //
-    int ENEMY_COUNT = 1;
-    
     // ————— DESTRUCTOR ————— //
     ~LevelB();
     
     // ————— METHODS ————— //
+    void preload() override;
     void initialise() override;
     void update(float delta_time) override;
-    void render(ShaderProgram *program) override;
-    void set_player(Entity* player);
+    void render(ShaderProgram *program, float alpha) override;
+    void set_player(Entity* player) override;
 
 };
@@ -1,39 +1,41 @@
 #include "LevelC.h"
 #include "Utility.h"
-
-#define LEVEL_WIDTH 14
-#define LEVEL_HEIGHT 8
+#include "AudioSystem.h"
 
 constexpr char SPRITESHEET_FILEPATH[] = "assets/DinoSprites.png",
+           LEVEL_FILEPATH[]       = "assets/levels/level_c.lvl",
            ENEMY_FILEPATH[]       = "assets/aiplatformerenemy.png";
 
-unsigned int LEVELC_DATA[] =
-{
-    160, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 160,
-    160, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    160, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 160,
-    160, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 0, 0, 160,
-    160, 0, 0, 0, 2, 2, 0, 0, 0, 0, 0, 0, 0, 160,
-    160, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 160,
-    160, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
-    160, 162, 162, 162, 162, 162, 162, 162, 162, 162, 162, 162, 162, 162
-};
-
 LevelC::~LevelC()
 {
-    delete [] m_game_state.enemies;
-    delete    m_game_state.player;
+    delete    m_game_state.enemies;
     delete    m_game_state.map;
-    Mix_FreeChunk(m_game_state.jump_sfx);
-    Mix_FreeChunk(m_game_state.hit_sfx);
-    Mix_FreeChunk(m_game_state.win_sfx);
-    Mix_FreeMusic(m_game_state.bgm);
+    delete    m_game_state.level;
+    Utility::release_texture(m_game_state.map_texture);
+    Utility::release_texture(m_game_state.player_texture);
+    Utility::release_texture(m_game_state.enemy_texture);
+    Utility::release_sound(m_game_state.jump_sfx);
+    Utility::release_sound(m_game_state.hit_sfx);
+    Utility::release_sound(m_game_state.win_sfx);
+    Utility::release_music(m_game_state.bgm);
+}
+
+void LevelC::preload()
+{
+    m_game_state.level = new LevelFile(LEVEL_FILEPATH);
+    
+    Utility::prefetch_texture(m_game_state.level->get_tileset_path());
+    Utility::prefetch_texture(ENEMY_FILEPATH);
+    
+    // The texture id is filled in by initialise(), once it's on the GPU
+    m_game_state.map = new Map(m_game_state.level, 0, false);
 }
 
 void LevelC::initialise()
 {
-    GLuint map_texture_id = Utility::load_texture("assets/tilemap_packed.png");
-    m_game_state.map = new Map(LEVEL_WIDTH, LEVEL_HEIGHT, LEVELC_DATA, map_texture_id, 1.0f, 20, 12);
+    m_game_state.map_texture = Utility::acquire_texture(m_game_state.level->get_tileset_path());
+    m_game_state.map->set_texture_id(m_game_state.map_texture.id);
+    m_game_state.map->upload();
     /*
     GLuint player_texture_id = Utility::load_texture(SPRITESHEET_FILEPATH);
 
@@ -69,64 +71,65 @@ void LevelC::initialise()
      */
     /**
      Enemies' stuff */
-    GLuint enemy_texture_id = Utility::load_texture(ENEMY_FILEPATH);
-
-    m_game_state.enemies = new Entity[ENEMY_COUNT];
+    m_game_state.enemy_texture = Utility::acquire_texture(ENEMY_FILEPATH);
+    GLuint enemy_texture_id = m_game_state.enemy_texture.id;
 
-    for (int i = 0; i < ENEMY_COUNT; i++)
-    {
-    m_game_state.enemies[i] =  Entity(enemy_texture_id, 1.0f, 1.0f, 1.0f, ENEMY, PATROL, WALKING);
-    }
-
-
-    m_game_state.enemies[0].set_position(glm::vec3(13.0f, -5.0f, 0.0f));
-    m_game_state.enemies[0].set_movement(glm::vec3(0.0f));
-    m_game_state.enemies[0].set_acceleration(glm::vec3(0.0f, -9.81f, 0.0f));
+    m_game_state.enemies = new EntityStore();
+    m_game_state.enemies->spawn(*m_game_state.level, enemy_texture_id);
 
     /**
      BGM and SFX
      */
-    Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 4096);
-
-    m_game_state.bgm = Mix_LoadMUS("assets/aiplatbgm.mp3");
-    Mix_PlayMusic(m_game_state.bgm, -1);
-    Mix_VolumeMusic(0.0f);
-    
-    m_game_state.jump_sfx = Mix_LoadWAV("assets/aijump.wav");
-    m_game_state.win_sfx = Mix_LoadWAV("assets/winlevel.wav");
-    m_game_state.hit_sfx = Mix_LoadWAV("assets/aihit.wav");
+    m_game_state.bgm = Utility::acquire_music("assets/aiplatbgm.mp3");
+    m_game_state.jump_sfx = Utility::acquire_sound("assets/aijump.wav");
+    m_game_state.win_sfx = Utility::acquire_sound("assets/winlevel.wav");
+    m_game_state.hit_sfx = Utility::acquire_sound("assets/aihit.wav");
     
-    Mix_VolumeMusic(MIX_MAX_VOLUME / 2);
+    AudioSystem::play_music(m_game_state.bgm, MIX_MAX_VOLUME / 2);
 
 }
 
 void LevelC::update(float delta_time)
 {
-    m_game_state.player->update(delta_time, m_game_state.player, m_game_state.enemies, ENEMY_COUNT, m_game_state.map);
+    m_broad_phase.build(*m_game_state.enemies);
+    m_game_state.player->update(delta_time, m_game_state.player, m_game_state.enemies, m_game_state.map, &m_broad_phase);
     
-    for (int i = 0; i < ENEMY_COUNT; i++)
-    {
-        m_game_state.enemies[i].update(delta_time, m_game_state.player, NULL, NULL, m_game_state.map);
-    }
+    m_game_state.enemies->update(delta_time, m_game_state.player, m_game_state.map);
+    
+    // Enemies have moved, so file them again before looking for hits on the player
+    m_broad_phase.build(*m_game_state.enemies);
+    const std::vector<int> &nearby_enemies = m_broad_phase.query(m_game_state.player->get_position(),
+                                                                 m_game_state.player->get_width(),
+                                                                 m_game_state.player->get_height());
     
-    for (int i = 0; i < ENEMY_COUNT; i++) {
-        if (m_game_state.player->check_collision(&m_game_state.enemies[i]))
+    for (size_t i = 0; i < nearby_enemies.size(); i++) {
+        int enemy = nearby_enemies[i];
+        
+        if (m_game_state.player->check_collision(m_game_state.enemies->get_position(enemy),
+                                                 m_game_state.enemies->get_width(enemy),
+                                                 m_game_state.enemies->get_height(enemy)))
         {
             m_game_state.player->lose_life();
             std::cout << "Player hit! Lives left: " << m_game_state.player->get_lives() << std::endl;
-            Mix_PlayChannel(-1, m_game_state.hit_sfx, 0);
+            AudioSystem::play_sound(m_game_state.hit_sfx);
             m_game_state.player->set_position(glm::vec3(2.0f, 4.0f, 0.0f));
         }
     }
 }
 
 
-void LevelC::render(ShaderProgram *g_shader_program)
+void LevelC::render(ShaderProgram *g_shader_program, float alpha)
 {
     m_game_state.map->render(g_shader_program);
-    m_game_state.player->render(g_shader_program);
-    for (int i = 0; i < m_number_of_enemies; i++)
-            m_game_state.enemies[i].render(g_shader_program);
+    
+    // Every enemy in one instanced draw, then the player over the top of them
+    m_instance_batch.begin(m_game_state.enemy_texture.id, m_game_state.enemy_texture.region);
+    m_game_state.enemies->render(&m_instance_batch, alpha);
+    m_instance_batch.end(g_shader_program);
+    
+    m_sprite_batch.begin();
+    m_game_state.player->render(&m_sprite_batch, alpha);
+    m_sprite_batch.end(g_shader_program);
 }
 
 void LevelC::set_player(Entity* player) {
@@ -2,17 +2,15 @@
 
 class LevelC : public Scene {
 public:
-    // ————— STATIC ATTRIBUTES ————— //
-    int ENEMY_COUNT = 1;
-    
     // ————— DESTRUCTOR ————— //
     ~LevelC();
     
     // ————— METHODS ————— //
+    void preload() override;
     void initialise() override;
     void update(float delta_time) override;
-    void render(ShaderProgram *program) override;
-    void set_player(Entity* player);
+    void render(ShaderProgram *program, float alpha) override;
+    void set_player(Entity* player) override;
 
 
 };
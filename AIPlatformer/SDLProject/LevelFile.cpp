@@ -0,0 +1,191 @@
+#define LOG(argument) std::cout << argument << '\n'
+
+#include "LevelFile.h"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WINDOWS
+#include <cstdlib>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static uint32_t align_to_4(size_t offset)
+{
+    return (uint32_t) ((offset + 3) & ~(size_t) 3);
+}
+
+LevelFile::LevelFile(const char *filepath)
+{
+#ifdef _WINDOWS
+    // No mmap here; read it into one block instead
+    FILE *file = fopen(filepath, "rb");
+    if (file != NULL)
+    {
+        fseek(file, 0, SEEK_END);
+        m_size = (size_t) ftell(file);
+        fseek(file, 0, SEEK_SET);
+        
+        m_data = malloc(m_size);
+        if (m_data != NULL && fread(m_data, 1, m_size, file) != m_size)
+        {
+            free(m_data);
+            m_data = nullptr;
+        }
+        fclose(file);
+    }
+#else
+    int file = open(filepath, O_RDONLY);
+    struct stat status;
+    
+    if (file >= 0 && fstat(file, &status) == 0 && status.st_size > 0)
+    {
+        m_size = (size_t) status.st_size;
+        
+        // Private and writable: edits land in copy-on-write pages, never the file
+        m_data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+        if (m_data == MAP_FAILED) m_data = nullptr;
+    }
+    
+    // The mapping keeps the file alive on its own
+    if (file >= 0) close(file);
+#endif
+    
+    if (m_data == nullptr || !validate(filepath))
+    {
+        LOG("Unable to load level " << filepath << ". Make sure the path is correct.");
+        assert(false);
+    }
+}
+
+LevelFile::~LevelFile()
+{
+    if (m_data == nullptr) return;
+    
+#ifdef _WINDOWS
+    free(m_data);
+#else
+    munmap(m_data, m_size);
+#endif
+}
+
+bool LevelFile::validate(const char *filepath)
+{
+    const LevelFileHeader *header = (const LevelFileHeader *) m_data;
+    
+    if (m_size < offsetof(LevelFileHeader, chunk_size) ||
+        (header->version >= 2 && m_size < sizeof(LevelFileHeader))) return false;
+    
+    if (memcmp(header->magic, LEVEL_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version < 1 || header->version > LEVEL_FILE_VERSION)
+    {
+        LOG(filepath << " is not a level file this build can read");
+        return false;
+    }
+    
+    // Version 1 headers stop before chunk_size
+    uint32_t chunk_size = header->version >= 2 ? header->chunk_size : 0;
+    
+    // Everything downstream reads these as ints, and a chunked file is only any use if its
+    // blocks are the map's chunks; checked first, so the sizes below can't overflow
+    if (header->width > INT32_MAX || header->height > INT32_MAX ||
+        (chunk_size != 0 && chunk_size != LEVEL_FILE_CHUNK_SIZE))
+    {
+        LOG(filepath << " has a size or chunk size this build can't read");
+        return false;
+    }
+    
+    m_chunk_size = (int) chunk_size;
+    
+    // Every section has to sit inside the file, aligned for its type
+    uint64_t tiles_size   = (uint64_t) get_stored_tile_count(header->width, header->height, m_chunk_size) * sizeof(uint16_t),
+             enemies_size = (uint64_t) header->enemy_count * sizeof(LevelEnemySpawn);
+    
+    if (header->tiles_offset % alignof(uint16_t) != 0 || header->tiles_offset + tiles_size > m_size ||
+        header->enemies_offset % alignof(LevelEnemySpawn) != 0 || header->enemies_offset + enemies_size > m_size)
+    {
+        LOG(filepath << " is truncated or corrupt");
+        return false;
+    }
+    
+    if (memchr(header->tileset_path, '\0', LEVEL_TILESET_PATH_SIZE) == NULL) return false;
+    
+    unsigned char *bytes = (unsigned char *) m_data;
+    
+    m_header  = header;
+    m_tiles   = (uint16_t *) (bytes + header->tiles_offset);
+    m_enemies = (const LevelEnemySpawn *) (bytes + header->enemies_offset);
+    
+    return true;
+}
+
+size_t const LevelFile::get_stored_tile_count(int width, int height, int chunk_size)
+{
+    if (chunk_size <= 0) return (size_t) width * height;
+    
+    size_t chunk_count_x = (width  + chunk_size - 1) / chunk_size,
+           chunk_count_y = (height + chunk_size - 1) / chunk_size;
+    
+    return chunk_count_x * chunk_count_y * chunk_size * chunk_size;
+}
+
+size_t LevelFile::release_tiles(size_t first_tile, size_t tile_count)
+{
+#ifdef _WINDOWS
+    return 0;
+#else
+    size_t page_size = get_tiles_per_page() * sizeof(uint16_t);
+    
+    // Round inwards: a page that's partly outside the run may hold tiles still in use
+    uintptr_t first = (uintptr_t) (m_tiles + first_tile),
+              last  = (uintptr_t) (m_tiles + first_tile + tile_count);
+    
+    first = (first + page_size - 1) / page_size * page_size;
+    last  = last / page_size * page_size;
+    
+    if (last <= first) return 0;
+    
+    madvise((void *) first, last - first, MADV_DONTNEED);
+    return last - first;
+#endif
+}
+
+size_t const LevelFile::get_tiles_per_page()
+{
+#ifdef _WINDOWS
+    return 0;
+#else
+    static const size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+    return page_size / sizeof(uint16_t);
+#endif
+}
+
+bool LevelFile::write(const char *filepath, LevelFileHeader header, const uint16_t *tiles,
+                      const LevelEnemySpawn *enemies)
+{
+    size_t tiles_size = get_stored_tile_count(header.width, header.height, header.chunk_size) * sizeof(uint16_t);
+    
+    memcpy(header.magic, LEVEL_FILE_MAGIC, sizeof(header.magic));
+    header.version        = LEVEL_FILE_VERSION;
+    header.tiles_offset   = header.chunk_size > 0 ? LEVEL_FILE_PAGE_ALIGN : align_to_4(sizeof(LevelFileHeader));
+    header.enemies_offset = align_to_4(header.tiles_offset + tiles_size);
+    
+    FILE *file = fopen(filepath, "wb");
+    if (file == NULL) return false;
+    
+    static const char padding[LEVEL_FILE_PAGE_ALIGN] = { 0 };
+    size_t tiles_padding = header.enemies_offset - (header.tiles_offset + tiles_size);
+    
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(padding, 1, header.tiles_offset - sizeof(header), file) == header.tiles_offset - sizeof(header) &&
+                   fwrite(tiles, 1, tiles_size, file) == tiles_size &&
+                   fwrite(padding, 1, tiles_padding, file) == tiles_padding &&
+                   fwrite(enemies, sizeof(LevelEnemySpawn), header.enemy_count, file) == header.enemy_count;
+    
+    return fclose(file) == 0 && written;
+}
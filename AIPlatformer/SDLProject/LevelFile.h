@@ -0,0 +1,112 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+    A level on disk (.lvl), little-endian, laid out as:
+        LevelFileHeader
+        (padding to LEVEL_FILE_PAGE_ALIGN, chunked files only)
+        uint16_t tiles[...]                   0 is empty
+        (padding to a 4-byte boundary)
+        LevelEnemySpawn enemies[enemy_count]
+    With chunk_size 0 the tiles are row-major from the top-left, width * height of
+    them. Otherwise they're stored as chunk_size × chunk_size blocks, block by block
+    left to right then top to bottom, each block row-major and the blocks on the right
+    and bottom edges padded with 0, so one chunk's tiles are contiguous on disk. Those
+    tiles start on a page boundary, so a run of whole blocks is a run of whole pages.
+    
+    The sections are found through the header's offsets, so a later version can put
+    more between them. Version 1 files have no chunk_size and are always row-major.
+    tools/level_converter.cpp writes these from tile arrays.
+*/
+#define LEVEL_FILE_MAGIC        "LVL1"
+#define LEVEL_FILE_VERSION      2
+#define LEVEL_FILE_CHUNK_SIZE   16
+#define LEVEL_FILE_PAGE_ALIGN   16384 // the largest page size we ship on (Apple silicon)
+#define LEVEL_TILESET_PATH_SIZE 64
+
+struct LevelFileHeader
+{
+    char     magic[4];
+    uint32_t version;
+    uint32_t width,
+             height;
+    float    tile_size;
+    uint32_t tile_count_x,
+             tile_count_y;
+    char     tileset_path[LEVEL_TILESET_PATH_SIZE];
+    uint32_t enemy_count;
+    uint32_t tiles_offset,
+             enemies_offset;
+    uint32_t chunk_size;        // version 2 onwards
+};
+
+struct LevelEnemySpawn
+{
+    float    x,
+             y;
+    uint32_t ai_type,
+             ai_state;
+};
+
+/**
+    Maps a .lvl file into memory. The tiles are used in place: Map reads them straight
+    out of the mapping, and pages are only read from disk when something touches them,
+    so opening a level costs the same however wide it is. The mapping is private, so
+    Map::set_tile() edits a copy-on-write page and never the file itself.
+    
+    release_tiles() hands the pages behind a run of tiles back to the OS; touching them
+    again reads them back from the file, so it must never be used on edited tiles.
+*/
+class LevelFile
+{
+private:
+    void  *m_data = nullptr;
+    size_t m_size = 0;
+    
+    const LevelFileHeader *m_header  = nullptr;
+    uint16_t              *m_tiles   = nullptr;
+    const LevelEnemySpawn *m_enemies = nullptr;
+    
+    int m_chunk_size = 0;
+    
+    bool validate(const char *filepath);
+    
+public:
+    // ————— CONSTRUCTORS ————— //
+    LevelFile(const char *filepath);
+    ~LevelFile();
+    
+    // Owns the mapping, so it can't be copied
+    LevelFile(const LevelFile&)            = delete;
+    LevelFile& operator=(const LevelFile&) = delete;
+    
+    // ————— METHODS ————— //
+    // Fills in the magic, version and offsets, then writes all three sections. tiles
+    // must already be in the layout header.chunk_size asks for.
+    static bool write(const char *filepath, LevelFileHeader header, const uint16_t *tiles,
+                      const LevelEnemySpawn *enemies);
+    static size_t const get_stored_tile_count(int width, int height, int chunk_size);
+    
+    // Only whole pages inside the run are released; returns how many bytes that was
+    size_t release_tiles(size_t first_tile, size_t tile_count);
+    
+    // How many tiles release_tiles can hand back at a time; 0 where it can't at all
+    static size_t const get_tiles_per_page();
+    
+    // ————— GETTERS ————— //
+    bool const get_is_loaded() const { return m_header != nullptr; }
+    
+    int   const get_width()        const { return (int) m_header->width;        }
+    int   const get_height()       const { return (int) m_header->height;       }
+    float const get_tile_size()    const { return m_header->tile_size;          }
+    int   const get_tile_count_x() const { return (int) m_header->tile_count_x; }
+    int   const get_tile_count_y() const { return (int) m_header->tile_count_y; }
+    int   const get_chunk_size()   const { return m_chunk_size;                 }
+    
+    const char *get_tileset_path() const { return m_header->tileset_path; }
+    uint16_t   *get_tiles()        const { return m_tiles;                }
+    
+    int                    const  get_enemy_count()    const { return (int) m_header->enemy_count; }
+    const LevelEnemySpawn        &get_enemy(int index) const { return m_enemies[index];           }
+};
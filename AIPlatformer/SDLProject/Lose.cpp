@@ -1,39 +1,51 @@
 #include "Lose.h"
 #include "Utility.h"
-
-#define LEVEL_WIDTH 14
-#define LEVEL_HEIGHT 8
+#include "AudioSystem.h"
 
 constexpr char SPRITESHEET_FILEPATH[] = "assets/DinoSprites.png",
-           ENEMY_FILEPATH[]       = "assets/aiplatformerenemy.png";
-
-unsigned int Lose_DATA[] =
-{
-    160, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 160,
-    160, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 160,
-    160, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 160,
-    160, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    160, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    160, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 2, 2, 2,
-    160, 2, 2, 2, 2, 2, 2, 162, 162, 162, 162, 162, 162, 162,
-    160, 162, 162, 162, 162, 162, 162, 162, 162, 162, 162, 162, 162, 162
-};
+           LEVEL_FILEPATH[]       = "assets/levels/lose.lvl",
+           ENEMY_FILEPATH[]       = "assets/aiplatformerenemy.png",
+           FONT_FILEPATH[]        = "assets/font1.png";
 
 Lose::~Lose()
 {
-    delete [] m_game_state.enemies;
+    delete    m_game_state.enemies;
     delete    m_game_state.player;
     delete    m_game_state.map;
-    Mix_FreeChunk(m_game_state.jump_sfx);
-    Mix_FreeMusic(m_game_state.bgm);
+    delete    m_game_state.level;
+    delete    m_message_text;
+    Utility::release_texture(m_game_state.map_texture);
+    Utility::release_texture(m_game_state.player_texture);
+    Utility::release_texture(m_game_state.enemy_texture);
+    Utility::release_sound(m_game_state.jump_sfx);
+    Utility::release_sound(m_game_state.hit_sfx);
+    Utility::release_sound(m_game_state.win_sfx);
+    Utility::release_music(m_game_state.bgm);
+}
+
+void Lose::preload()
+{
+    m_game_state.level = new LevelFile(LEVEL_FILEPATH);
+    
+    Utility::prefetch_texture(m_game_state.level->get_tileset_path());
+    Utility::prefetch_texture(ENEMY_FILEPATH);
+    Utility::prefetch_texture(SPRITESHEET_FILEPATH);
+    Utility::prefetch_texture(FONT_FILEPATH);
+    
+    // The texture id is filled in by initialise(), once it's on the GPU
+    m_game_state.map = new Map(m_game_state.level, 0, false);
 }
 
 void Lose::initialise()
 {
-    GLuint map_texture_id = Utility::load_texture("assets/tilemap_packed.png");
-    m_game_state.map = new Map(LEVEL_WIDTH, LEVEL_HEIGHT, Lose_DATA, map_texture_id, 1.0f, 20, 12);
+    m_game_state.map_texture = Utility::acquire_texture(m_game_state.level->get_tileset_path());
+    m_game_state.map->set_texture_id(m_game_state.map_texture.id);
+    m_game_state.map->upload();
+    
+    m_message_text = new Text(FONT_FILEPATH, "YOU LOSE", 0.5f, 0.05f, glm::vec3(3.0f, -3.0f, 0.0f));
     
-    GLuint player_texture_id = Utility::load_texture(SPRITESHEET_FILEPATH);
+    m_game_state.player_texture = Utility::acquire_texture(SPRITESHEET_FILEPATH);
+    GLuint player_texture_id = m_game_state.player_texture.id;
 
     /*
     int player_walking_animation[4][4] =
@@ -76,53 +88,43 @@ void Lose::initialise()
     
     /**
      Enemies' stuff */
-    GLuint enemy_texture_id = Utility::load_texture(ENEMY_FILEPATH);
+    m_game_state.enemy_texture = Utility::acquire_texture(ENEMY_FILEPATH);
+    GLuint enemy_texture_id = m_game_state.enemy_texture.id;
 
-    m_game_state.enemies = new Entity[ENEMY_COUNT];
-
-    for (int i = 0; i < ENEMY_COUNT; i++)
-    {
-    m_game_state.enemies[i] =  Entity(enemy_texture_id, 1.0f, 1.0f, 1.0f, ENEMY, GUARD, IDLE);
-    }
-
-
-    m_game_state.enemies[0].set_position(glm::vec3(8.0f, 0.0f, 0.0f));
-    m_game_state.enemies[0].set_movement(glm::vec3(0.0f));
-    m_game_state.enemies[0].set_acceleration(glm::vec3(0.0f, -9.81f, 0.0f));
+    m_game_state.enemies = new EntityStore();
+    m_game_state.enemies->spawn(*m_game_state.level, enemy_texture_id);
 
     /**
      BGM and SFX
      */
-    Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 4096);
-
-    m_game_state.bgm = Mix_LoadMUS("assets/aiplatbgm.mp3");
-    Mix_PlayMusic(m_game_state.bgm, -1);
-    Mix_VolumeMusic(0.0f);
+    m_game_state.bgm = Utility::acquire_music("assets/aiplatbgm.mp3");
+    m_game_state.jump_sfx = Utility::acquire_sound("assets/aijump.wav");
+    m_game_state.win_sfx = Utility::acquire_sound("assets/winlevel.wav");
+    m_game_state.hit_sfx = Utility::acquire_sound("assets/aihit.wav");
     
-    m_game_state.jump_sfx = Mix_LoadWAV("assets/aijump.wav");
-    m_game_state.win_sfx = Mix_LoadWAV("assets/winlevel.wav");
-    m_game_state.hit_sfx = Mix_LoadWAV("assets/aihit.wav");
+    // The music keeps its place, just silenced
+    AudioSystem::play_music(m_game_state.bgm, 0);
 }
 
 void Lose::update(float delta_time)
 {
-    m_game_state.player->update(delta_time, m_game_state.player, m_game_state.enemies, ENEMY_COUNT, m_game_state.map);
+    m_game_state.player->update(delta_time, m_game_state.player, m_game_state.enemies, m_game_state.map);
     
     //for (int i = 0; i < ENEMY_COUNT; i++)
     //{
-    //    m_game_state.enemies[i].update(delta_time, m_game_state.player, NULL, NULL, m_game_state.map);
+    //    m_game_state.enemies->update(delta_time, m_game_state.player, m_game_state.map);
     //}
 }
 
 
-void Lose::render(ShaderProgram *g_shader_program)
+void Lose::render(ShaderProgram *g_shader_program, float /*alpha*/)
 {
    // m_game_state.map->render(g_shader_program);
     //m_game_state.player->render(g_shader_program);
     //for (int i = 0; i < m_number_of_enemies; i++)
      //       m_game_state.enemies[i].render(g_shader_program);
     
-    Utility::draw_text(g_shader_program, Utility::load_texture("assets/font1.png"), "YOU LOSE", 0.5f, 0.05f, glm::vec3(3.0f, -3.0f, 0.0f));
+    m_message_text->render(g_shader_program);
 
 
 }
@@ -1,53 +1,193 @@
+#define FLOATS_PER_VERTEX 4
+#define VERTICES_PER_TILE 4
+#define INDICES_PER_TILE  6
+#define FLOATS_PER_TILE   (FLOATS_PER_VERTEX * VERTICES_PER_TILE)
+#define TILES_PER_CHUNK   (Map::CHUNK_SIZE * Map::CHUNK_SIZE)
+#define COLLISION_SKIN    0.001f
+#define CHUNK_BYTES       (TILES_PER_CHUNK * FLOATS_PER_TILE * sizeof(float) + TILES_PER_CHUNK * sizeof(uint16_t))
+#define LOG(argument)     std::cout << argument << '\n'
+
 #include "Map.h"
+#include "Simulation.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <iostream>
+
+// A chunked file can only be read a chunk at a time if its blocks are our chunks;
+// LevelFile turns away any other chunk size when it's loaded
+static_assert(Map::CHUNK_SIZE == LEVEL_FILE_CHUNK_SIZE, "Map chunks have to match the level file's");
+
+// The chunks within radius of the centre chunk, all of which streaming keeps meshed
+static size_t working_set_bytes(int radius)
+{
+    size_t side = 2 * (size_t) radius + 1;
+    return side * side * CHUNK_BYTES;
+}
 
-Map::Map(int width, int height, unsigned int *level_data, GLuint texture_id, float tile_size, int tile_count_x, int tile_count_y) : 
+Map::Map(int width, int height, uint16_t *level_data, GLuint texture_id, float tile_size, int tile_count_x, int tile_count_y, bool upload) : 
 m_width(width), m_height(height), m_level_data(level_data), m_texture_id(texture_id), m_tile_size(tile_size), m_tile_count_x(tile_count_x), m_tile_count_y(tile_count_y)
 {
-    build();
+    if (upload) build();
+    else        prepare();
 }
 
-void Map::build()
+Map::Map(LevelFile *level, GLuint texture_id, bool upload, MapStreamSettings streaming) :
+m_width(level->get_width()), m_height(level->get_height()), m_level_data(level->get_tiles()), m_texture_id(texture_id), m_tile_size(level->get_tile_size()), m_tile_count_x(level->get_tile_count_x()), m_tile_count_y(level->get_tile_count_y())
+{
+    m_level_file        = level;
+    m_layout_chunk_size = level->get_chunk_size();
+    m_is_streaming      = m_layout_chunk_size != 0 && streaming.radius > 0;
+    m_stream_settings   = streaming;
+    
+    if (m_is_streaming) fit_stream_budget();
+    
+    if (upload) build();
+    else        prepare();
+}
+
+Map::~Map()
+{
+    release_buffers();
+}
+
+void Map::release_buffers()
+{
+    for (MapChunk &chunk : m_chunks)
+    {
+        if (chunk.vertex_buffer != 0) glDeleteBuffers(1, &chunk.vertex_buffer);
+        chunk.vertex_buffer = 0;
+    }
+    
+    if (m_index_buffer != 0) glDeleteBuffers(1, &m_index_buffer);
+    m_index_buffer = 0;
+    m_is_uploaded  = false;
+}
+
+void Map::write_tile_vertices(int x_coord, int y_coord, float *vertices) const
+{
+    // Get the current tile; chunks on the right and bottom edges hang off the map
+    bool in_map = x_coord < m_width && y_coord < m_height;
+    int  tile   = in_map ? m_level_data[tile_index(x_coord, y_coord)] : 0;
+    
+    // If the tile number is 0 i.e. not solid, collapse its quad to a point
+    if (tile == 0)
+    {
+        std::fill(vertices, vertices + FLOATS_PER_TILE, 0.0f);
+        return;
+    }
+    
+    // Otherwise, calculate its UV-coordinated
+    float u_coord = (float) (tile % m_tile_count_x) / (float) m_tile_count_x;
+    float v_coord = (float) (tile / m_tile_count_x) / (float) m_tile_count_y;
+    
+    // And work out their dimensions and posititions
+    float tile_width = 1.0f/ (float)  m_tile_count_x;
+    float tile_height = 1.0f/ (float) m_tile_count_y;
+    
+    float x_offset = -(m_tile_size / 2); // From center of tile
+    float y_offset =  (m_tile_size / 2); // From center of tile
+    
+    float left   = x_offset + (m_tile_size * x_coord),
+          right  = left + m_tile_size,
+          top    = y_offset + (-m_tile_size * y_coord),
+          bottom = top - m_tile_size;
+    
+    // Top-left, bottom-left, bottom-right, top-right
+    float quad[FLOATS_PER_TILE] = {
+        left,  top,    u_coord,              v_coord,
+        left,  bottom, u_coord,              v_coord + tile_height,
+        right, bottom, u_coord + tile_width, v_coord + tile_height,
+        right, top,    u_coord + tile_width, v_coord
+    };
+    
+    std::copy(quad, quad + FLOATS_PER_TILE, vertices);
+}
+
+int Map::write_chunk_vertices(int chunk_x, int chunk_y, std::vector<float> &vertices) const
 {
+    int first_x = chunk_x * CHUNK_SIZE,
+        first_y = chunk_y * CHUNK_SIZE;
+    
     // Since this is a 2D map, we need a nested for-loop
-    for(int y_coord = 0; y_coord < m_height; y_coord++)
+    vertices.resize(TILES_PER_CHUNK * FLOATS_PER_TILE);
+    int solid_tiles = 0;
+    
+    for (int y_coord = 0; y_coord < CHUNK_SIZE; y_coord++)
     {
-        for(int x_coord = 0; x_coord < m_width; x_coord++)
+        for (int x_coord = 0; x_coord < CHUNK_SIZE; x_coord++)
         {
-            // Get the current tile
-            int tile = m_level_data[y_coord * m_width + x_coord];
-            
-            // If the tile number is 0 i.e. not solid, skip to the next one
-            if (tile == 0) continue;
-            
-            // Otherwise, calculate its UV-coordinated
-            float u_coord = (float) (tile % m_tile_count_x) / (float) m_tile_count_x;
-            float v_coord = (float) (tile / m_tile_count_x) / (float) m_tile_count_y;
-            
-            // And work out their dimensions and posititions
-            float tile_width = 1.0f/ (float)  m_tile_count_x;
-            float tile_height = 1.0f/ (float) m_tile_count_y;
+            int map_x = first_x + x_coord,
+                map_y = first_y + y_coord;
             
-            float x_offset = -(m_tile_size / 2); // From center of tile
-            float y_offset =  (m_tile_size / 2); // From center of tile
+            if (map_x < m_width && map_y < m_height && m_level_data[tile_index(map_x, map_y)] != 0) solid_tiles++;
             
-            // So we can store them inside our std::vectors
-            m_vertices.insert(m_vertices.end(), {
-                x_offset + (m_tile_size * x_coord),  y_offset +  -m_tile_size * y_coord,
-                x_offset + (m_tile_size * x_coord),  y_offset + (-m_tile_size * y_coord) - m_tile_size,
-                x_offset + (m_tile_size * x_coord) + m_tile_size, y_offset + (-m_tile_size * y_coord) - m_tile_size,
-                x_offset + (m_tile_size * x_coord), y_offset + -m_tile_size * y_coord,
-                x_offset + (m_tile_size * x_coord) + m_tile_size, y_offset + (-m_tile_size * y_coord) - m_tile_size,
-                x_offset + (m_tile_size * x_coord) + m_tile_size, y_offset +  -m_tile_size * y_coord
-            });
+            write_tile_vertices(map_x, map_y, &vertices[(y_coord * CHUNK_SIZE + x_coord) * FLOATS_PER_TILE]);
+        }
+    }
+    
+    return solid_tiles;
+}
+
+void Map::upload_chunk(MapChunk &chunk, const std::vector<float> &vertices)
+{
+    // Nothing to draw: don't hold a buffer for it
+    if (chunk.solid_tiles == 0)
+    {
+        if (chunk.vertex_buffer != 0) glDeleteBuffers(1, &chunk.vertex_buffer);
+        chunk.vertex_buffer = 0;
+        return;
+    }
+    
+    if (chunk.vertex_buffer == 0) glGenBuffers(1, &chunk.vertex_buffer);
+    
+    glBindBuffer(GL_ARRAY_BUFFER, chunk.vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Map::build_chunk(int chunk_x, int chunk_y)
+{
+    MapChunk &chunk = m_chunks[chunk_y * m_chunk_count_x + chunk_x];
+    
+    std::vector<float> vertices;
+    int solid_tiles = write_chunk_vertices(chunk_x, chunk_y, vertices);
+    
+    if (chunk.solid_tiles > 0) m_solid_chunks--;
+    chunk.solid_tiles = solid_tiles;
+    if (chunk.solid_tiles > 0) m_solid_chunks++;
+    
+    upload_chunk(chunk, vertices);
+}
+
+void Map::build()
+{
+    release_buffers();
+    prepare();
+    upload();
+}
+
+void Map::prepare()
+{
+    // Work out every chunk's vertices on the CPU; nothing here touches GL
+    m_chunk_count_x = (m_width  + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    m_chunk_count_y = (m_height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    m_chunks.assign(m_chunk_count_x * m_chunk_count_y, MapChunk());
+    m_solid_chunks = 0;
+    
+    // A streaming map meshes its chunks as the view reaches them instead
+    m_meshed_chunks.clear();
+    m_stream_stats = MapStreamStats();
+    
+    for (MapChunk &chunk : m_chunks) chunk.is_meshed = !m_is_streaming;
+    
+    for (int chunk_y = 0; chunk_y < m_chunk_count_y && !m_is_streaming; chunk_y++)
+    {
+        for (int chunk_x = 0; chunk_x < m_chunk_count_x; chunk_x++)
+        {
+            MapChunk &chunk = m_chunks[chunk_y * m_chunk_count_x + chunk_x];
             
-            m_texture_coordinates.insert(m_texture_coordinates.end(), {
-                u_coord, v_coord,
-                u_coord, v_coord + (tile_height),
-                u_coord + tile_width, v_coord + (tile_height),
-                u_coord, v_coord,
-                u_coord + tile_width, v_coord + (tile_height),
-                u_coord + tile_width, v_coord
-            });
+            chunk.solid_tiles = write_chunk_vertices(chunk_x, chunk_y, chunk.staged_vertices);
+            if (chunk.solid_tiles > 0) m_solid_chunks++;
         }
     }
     
@@ -58,23 +198,278 @@ void Map::build()
     m_bottom_bound = -(m_tile_size * m_height) + (m_tile_size / 2);
 }
 
+void Map::upload()
+{
+    if (m_is_uploaded) return;
+    
+    // Every quad is two triangles over its four vertices, and every chunk has the same
+    // number of quads, so one index buffer serves all of them
+    std::vector<GLushort> indices;
+    indices.reserve(TILES_PER_CHUNK * INDICES_PER_TILE);
+    for (GLushort tile = 0; tile < TILES_PER_CHUNK; tile++)
+    {
+        GLushort first = tile * VERTICES_PER_TILE;
+        indices.insert(indices.end(), {
+            first, (GLushort) (first + 1), (GLushort) (first + 2),
+            first, (GLushort) (first + 2), (GLushort) (first + 3)
+        });
+    }
+    
+    if (m_index_buffer == 0) glGenBuffers(1, &m_index_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_index_buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    
+    // Upload each chunk once; from here on only set_tile touches them
+    for (MapChunk &chunk : m_chunks)
+    {
+        upload_chunk(chunk, chunk.staged_vertices);
+        std::vector<float>().swap(chunk.staged_vertices);
+    }
+    
+    m_is_uploaded = true;
+}
+
+void Map::set_tile(int x_coord, int y_coord, uint16_t tile)
+{
+    if (x_coord < 0 || x_coord >= m_width)  return;
+    if (y_coord < 0 || y_coord >= m_height) return;
+    
+    int index = tile_index(x_coord, y_coord);
+    if (m_level_data[index] == tile) return;
+    
+    uint16_t previous_tile = m_level_data[index];
+    m_level_data[index] = tile;
+    
+    int chunk_x = x_coord / CHUNK_SIZE,
+        chunk_y = y_coord / CHUNK_SIZE;
+    MapChunk &chunk = m_chunks[chunk_y * m_chunk_count_x + chunk_x];
+    chunk.is_dirty = true;
+    
+    // Not meshed: it picks the edit up whenever the view brings it in
+    if (!chunk.is_meshed) return;
+
+    // Not on the GPU yet: the staged copy is what upload() will send
+    if (!m_is_uploaded)
+    {
+        if (chunk.solid_tiles > 0) m_solid_chunks--;
+        chunk.solid_tiles = write_chunk_vertices(chunk_x, chunk_y, chunk.staged_vertices);
+        if (chunk.solid_tiles > 0) m_solid_chunks++;
+        return;
+    }
+
+    // A chunk gaining its first tile or losing its last one is rebuilt whole
+    bool was_solid = previous_tile != 0,
+         is_solid  = tile != 0;
+    
+    if (chunk.vertex_buffer == 0 || (was_solid && !is_solid && chunk.solid_tiles == 1))
+    {
+        build_chunk(chunk_x, chunk_y);
+        return;
+    }
+    
+    chunk.solid_tiles += (int) is_solid - (int) was_solid;
+    
+    // Otherwise only this tile's slot goes back to the GPU
+    float vertices[FLOATS_PER_TILE];
+    write_tile_vertices(x_coord, y_coord, vertices);
+    
+    int slot = (y_coord % CHUNK_SIZE) * CHUNK_SIZE + (x_coord % CHUNK_SIZE);
+    
+    glBindBuffer(GL_ARRAY_BUFFER, chunk.vertex_buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, slot * sizeof(vertices), sizeof(vertices), vertices);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Map::stream(float focus_x, float focus_y)
+{
+    float chunk_extent = m_tile_size * CHUNK_SIZE;
+    int   radius       = m_stream_settings.radius;
+    
+    int focus_chunk_x = std::min(std::max((int) floor((focus_x - m_left_bound) / chunk_extent), 0), m_chunk_count_x - 1),
+        focus_chunk_y = std::min(std::max((int) floor((m_top_bound - focus_y) / chunk_extent), 0), m_chunk_count_y - 1);
+    
+    // Mesh whatever inside the radius isn't yet
+    for (int chunk_y = std::max(focus_chunk_y - radius, 0); chunk_y <= std::min(focus_chunk_y + radius, m_chunk_count_y - 1); chunk_y++)
+    {
+        for (int chunk_x = std::max(focus_chunk_x - radius, 0); chunk_x <= std::min(focus_chunk_x + radius, m_chunk_count_x - 1); chunk_x++)
+        {
+            int index = chunk_y * m_chunk_count_x + chunk_x;
+            if (m_chunks[index].is_meshed) continue;
+            
+            build_chunk(chunk_x, chunk_y);
+            m_chunks[index].is_meshed = true;
+            m_meshed_chunks.push_back(index);
+            m_stream_stats.chunks_meshed++;
+        }
+    }
+    
+    if (m_meshed_chunks.size() * CHUNK_BYTES <= m_stream_settings.budget) return;
+    
+    // Over budget: drop the farthest chunks first, but never one inside the radius
+    std::vector<std::pair<int, int>> candidates;
+    for (int index : m_meshed_chunks)
+    {
+        int distance = std::max(abs(index % m_chunk_count_x - focus_chunk_x), abs(index / m_chunk_count_x - focus_chunk_y));
+        if (distance > radius) candidates.push_back(std::make_pair(distance, index));
+    }
+    
+    std::sort(candidates.begin(), candidates.end(), std::greater<std::pair<int, int>>());
+    
+    size_t meshed = m_meshed_chunks.size();
+    for (const std::pair<int, int> &candidate : candidates)
+    {
+        if (meshed * CHUNK_BYTES <= m_stream_settings.budget) break;
+        
+        evict_chunk(candidate.second);
+        meshed--;
+    }
+    
+    m_meshed_chunks.erase(std::remove_if(m_meshed_chunks.begin(), m_meshed_chunks.end(),
+                                         [this](int index) { return !m_chunks[index].is_meshed; }),
+                          m_meshed_chunks.end());
+}
+
+void Map::fit_stream_budget()
+{
+    MapStreamSettings &settings = m_stream_settings;
+    
+    if (settings.budget == 0)
+    {
+        settings.budget = working_set_bytes(settings.radius + 1);
+        return;
+    }
+    
+    if (working_set_bytes(settings.radius) <= settings.budget) return;
+    
+    // Otherwise stream() would sit over budget for good, re-sorting the same chunks every
+    // frame without ever being allowed to drop one
+    int radius = settings.radius;
+    while (radius > 1 && working_set_bytes(radius) > settings.budget) radius--;
+    
+    LOG("Map: a " << settings.budget << " byte budget can't hold a streaming radius of " << settings.radius
+        << " chunks, using " << radius);
+    
+    settings.radius = radius;
+    settings.budget = std::max(settings.budget, working_set_bytes(radius));
+}
+
+void Map::evict_chunk(int index)
+{
+    MapChunk &chunk = m_chunks[index];
+    
+    if (chunk.vertex_buffer != 0) glDeleteBuffers(1, &chunk.vertex_buffer);
+    if (chunk.solid_tiles > 0)    m_solid_chunks--;
+    
+    chunk.vertex_buffer = 0;
+    chunk.solid_tiles   = 0;
+    chunk.is_meshed     = false;
+    
+    m_stream_stats.chunks_evicted++;
+    release_chunk_tiles(index);
+}
+
+void Map::release_chunk_tiles(int index)
+{
+    // A page holds several chunks' tiles, so it goes back only once none of them are
+    // meshed; edited tiles never do, as they'd fault back in from the file unedited
+    int per_page = std::max((int) (LevelFile::get_tiles_per_page() / TILES_PER_CHUNK), 1),
+        first    = index / per_page * per_page,
+        last     = std::min(first + per_page, (int) m_chunks.size());
+    
+    for (int other = first; other < last; other++)
+        if (m_chunks[other].is_meshed || m_chunks[other].is_dirty) return;
+    
+    m_stream_stats.bytes_released += m_level_file->release_tiles((size_t) first * TILES_PER_CHUNK,
+                                                                 (size_t) (last - first) * TILES_PER_CHUNK);
+}
+
+MapStreamStats const Map::get_stream_stats() const
+{
+    MapStreamStats stats   = m_stream_stats;
+    stats.resident_chunks  = m_is_streaming ? (int) m_meshed_chunks.size() : (int) m_chunks.size();
+    stats.resident_bytes   = stats.resident_chunks * CHUNK_BYTES;
+    
+    return stats;
+}
+
+void Map::set_view_bounds(float left, float right, float top, float bottom)
+{
+    m_has_view_bounds = true;
+    m_view_left   = left;
+    m_view_right  = right;
+    m_view_top    = top;
+    m_view_bottom = bottom;
+}
+
+void Map::draw_chunk(const MapChunk &chunk, ShaderProgram *program)
+{
+    GLsizei stride = FLOATS_PER_VERTEX * sizeof(float);
+    
+    glBindBuffer(GL_ARRAY_BUFFER, chunk.vertex_buffer);
+    glVertexAttribPointer(program->get_position_attribute(), 2, GL_FLOAT, false, stride, (void*) 0);
+    glVertexAttribPointer(program->get_tex_coordinate_attribute(), 2, GL_FLOAT, false, stride, (void*) (2 * sizeof(float)));
+    
+    glDrawElements(GL_TRIANGLES, TILES_PER_CHUNK * INDICES_PER_TILE, GL_UNSIGNED_SHORT, (void*) 0);
+    
+    m_render_stats.chunks_drawn++;
+}
+
 void Map::render(ShaderProgram *program)
 {
+    PROFILE_SCOPE("map render");
+    
+    m_render_stats = MapRenderStats();
+    
+    // Bring in the chunks around the middle of the view before drawing any of them
+    if (m_is_streaming)
+    {
+        if (m_has_view_bounds) stream((m_view_left + m_view_right) / 2, (m_view_top + m_view_bottom) / 2);
+        else                   stream(m_left_bound, m_top_bound);
+    }
+    
     glm::mat4 model_matrix = glm::mat4(1.0f);
     program->set_model_matrix(model_matrix);
     
-    glUseProgram(program->get_program_id());
+    program->use();
     
-    glVertexAttribPointer(program->get_position_attribute(), 2, GL_FLOAT, false, 0, m_vertices.data());
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_index_buffer);
     glEnableVertexAttribArray(program->get_position_attribute());
-    glVertexAttribPointer(program->get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, m_texture_coordinates.data());
     glEnableVertexAttribArray(program->get_tex_coordinate_attribute());
     
     glBindTexture(GL_TEXTURE_2D, m_texture_id);
     
-    glDrawArrays(GL_TRIANGLES, 0, (int) m_vertices.size() / 2);
+    // Only walk the chunks whose columns and rows overlap the view
+    int first_chunk_x = 0, last_chunk_x = m_chunk_count_x - 1,
+        first_chunk_y = 0, last_chunk_y = m_chunk_count_y - 1;
+    
+    if (m_has_view_bounds)
+    {
+        float chunk_extent = m_tile_size * CHUNK_SIZE;
+        
+        first_chunk_x = std::max(first_chunk_x, (int) floor((m_view_left  - m_left_bound) / chunk_extent));
+        last_chunk_x  = std::min(last_chunk_x,  (int) floor((m_view_right - m_left_bound) / chunk_extent));
+        first_chunk_y = std::max(first_chunk_y, (int) floor((m_top_bound - m_view_top)    / chunk_extent));
+        last_chunk_y  = std::min(last_chunk_y,  (int) floor((m_top_bound - m_view_bottom) / chunk_extent));
+    }
+    
+    for (int chunk_y = first_chunk_y; chunk_y <= last_chunk_y; chunk_y++)
+    {
+        for (int chunk_x = first_chunk_x; chunk_x <= last_chunk_x; chunk_x++)
+        {
+            const MapChunk &chunk = m_chunks[chunk_y * m_chunk_count_x + chunk_x];
+            if (chunk.vertex_buffer != 0) draw_chunk(chunk, program);
+        }
+    }
+    
+    m_render_stats.chunks_culled = m_solid_chunks - m_render_stats.chunks_drawn;
+    
     glDisableVertexAttribArray(program->get_position_attribute());
     glDisableVertexAttribArray(program->get_tex_coordinate_attribute());
+    
+    // Entities still draw from client-side arrays
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 bool Map::is_solid(glm::vec3 position, float *penetration_x, float *penetration_y)
@@ -99,7 +494,7 @@ bool Map::is_solid(glm::vec3 position, float *penetration_x, float *penetration_
     if (tile_y < 0 || tile_y >= m_height) return false;
     
     // If the tile index is 0 i.e. an open space, it is not solid
-    int tile = m_level_data[tile_y * m_width + tile_x];
+    int tile = m_level_data[tile_index(tile_x, tile_y)];
     if (tile == 0) return false;
     
     // And we likely have some overlap
@@ -112,3 +507,185 @@ bool Map::is_solid(glm::vec3 position, float *penetration_x, float *penetration_
     
     return true;
 }
+
+int const Map::column_of(float x) const
+{
+    return (int) floor((x - m_left_bound) / m_tile_size);
+}
+
+int const Map::row_of(float y) const
+{
+    // Our array counts up as Y goes down
+    return (int) floor((m_top_bound - y) / m_tile_size);
+}
+
+bool const Map::is_span_solid(int first_x, int last_x, int first_y, int last_y) const
+{
+    // Anything outside the map is open space
+    first_x = std::max(first_x, 0);
+    first_y = std::max(first_y, 0);
+    last_x  = std::min(last_x, m_width  - 1);
+    last_y  = std::min(last_y, m_height - 1);
+    
+    for (int y_coord = first_y; y_coord <= last_y; y_coord++)
+        for (int x_coord = first_x; x_coord <= last_x; x_coord++)
+            if (m_level_data[tile_index(x_coord, y_coord)] != 0) return true;
+    
+    return false;
+}
+
+MapCollision const Map::sweep_y(glm::vec3 position, float width, float height, float sweep) const
+{
+    MapCollision collision;
+    if (sweep == 0.0f) return collision;
+    
+    if (Simulation::get_is_deterministic()) return sweep_y_fixed(position, width, height, sweep);
+    
+    // The columns we actually overlap; the skin stops us snagging on the tiles next to us
+    int first_x = column_of(position.x - (width / 2) + COLLISION_SKIN),
+        last_x  = column_of(position.x + (width / 2) - COLLISION_SKIN);
+    
+    // Walk the rows the leading edge passed through, nearest first, and stop at the
+    // first one with something solid in it
+    float edge     = position.y + (sweep > 0 ? height / 2 : -height / 2);
+    int   start_y  = row_of(edge - sweep),
+          end_y    = row_of(edge),
+          step     = end_y >= start_y ? 1 : -1;
+    
+    for (int y_coord = start_y; ; y_coord += step)
+    {
+        if (is_span_solid(first_x, last_x, y_coord, y_coord))
+        {
+            float tile_top    = m_top_bound - (y_coord * m_tile_size),
+                  tile_bottom = tile_top - m_tile_size;
+            
+            collision.collided   = true;
+            collision.correction = sweep > 0 ? tile_bottom - edge : tile_top - edge;
+            return collision;
+        }
+        
+        if (y_coord == end_y) break;
+    }
+    
+    return collision;
+}
+
+MapCollision const Map::sweep_x(glm::vec3 position, float width, float height, float sweep) const
+{
+    MapCollision collision;
+    if (sweep == 0.0f) return collision;
+    
+    if (Simulation::get_is_deterministic()) return sweep_x_fixed(position, width, height, sweep);
+    
+    int first_y = row_of(position.y + (height / 2) - COLLISION_SKIN),
+        last_y  = row_of(position.y - (height / 2) + COLLISION_SKIN);
+    
+    float edge     = position.x + (sweep > 0 ? width / 2 : -width / 2);
+    int   start_x  = column_of(edge - sweep),
+          end_x    = column_of(edge),
+          step     = end_x >= start_x ? 1 : -1;
+    
+    for (int x_coord = start_x; ; x_coord += step)
+    {
+        if (is_span_solid(x_coord, x_coord, first_y, last_y))
+        {
+            float tile_left  = m_left_bound + (x_coord * m_tile_size),
+                  tile_right = tile_left + m_tile_size;
+            
+            collision.collided   = true;
+            collision.correction = sweep > 0 ? tile_left - edge : tile_right - edge;
+            return collision;
+        }
+        
+        if (x_coord == end_x) break;
+    }
+    
+    return collision;
+}
+
+// ————— DETERMINISTIC SWEEPS ————— //
+int const Map::column_of_fixed(fixed_t x) const
+{
+    return FixedPoint::floor_div(x - FixedPoint::from_float(m_left_bound), FixedPoint::from_float(m_tile_size));
+}
+
+int const Map::row_of_fixed(fixed_t y) const
+{
+    return FixedPoint::floor_div(FixedPoint::from_float(m_top_bound) - y, FixedPoint::from_float(m_tile_size));
+}
+
+MapCollision const Map::sweep_y_fixed(glm::vec3 position, float width, float height, float sweep) const
+{
+    MapCollision collision;
+    
+    fixed_t x           = FixedPoint::from_float(position.x),
+            y           = FixedPoint::from_float(position.y),
+            half_width  = FixedPoint::from_float(width)  / 2,
+            half_height = FixedPoint::from_float(height) / 2,
+            move        = FixedPoint::from_float(sweep),
+            skin        = FixedPoint::from_float(COLLISION_SKIN),
+            tile_size   = FixedPoint::from_float(m_tile_size);
+    
+    int first_x = column_of_fixed(x - half_width + skin),
+        last_x  = column_of_fixed(x + half_width - skin);
+    
+    fixed_t edge    = y + (move > 0 ? half_height : -half_height);
+    int     start_y = row_of_fixed(edge - move),
+            end_y   = row_of_fixed(edge),
+            step    = end_y >= start_y ? 1 : -1;
+    
+    for (int y_coord = start_y; ; y_coord += step)
+    {
+        if (is_span_solid(first_x, last_x, y_coord, y_coord))
+        {
+            fixed_t tile_top    = FixedPoint::from_float(m_top_bound) - y_coord * tile_size,
+                    tile_bottom = tile_top - tile_size;
+            
+            collision.collided   = true;
+            collision.correction = FixedPoint::to_float(move > 0 ? tile_bottom - edge : tile_top - edge);
+            return collision;
+        }
+        
+        if (y_coord == end_y) break;
+    }
+    
+    return collision;
+}
+
+MapCollision const Map::sweep_x_fixed(glm::vec3 position, float width, float height, float sweep) const
+{
+    MapCollision collision;
+    
+    fixed_t x           = FixedPoint::from_float(position.x),
+            y           = FixedPoint::from_float(position.y),
+            half_width  = FixedPoint::from_float(width)  / 2,
+            half_height = FixedPoint::from_float(height) / 2,
+            move        = FixedPoint::from_float(sweep),
+            skin        = FixedPoint::from_float(COLLISION_SKIN),
+            tile_size   = FixedPoint::from_float(m_tile_size);
+    
+    int first_y = row_of_fixed(y + half_height - skin),
+        last_y  = row_of_fixed(y - half_height + skin);
+    
+    fixed_t edge    = x + (move > 0 ? half_width : -half_width);
+    int     start_x = column_of_fixed(edge - move),
+            end_x   = column_of_fixed(edge),
+            step    = end_x >= start_x ? 1 : -1;
+    
+    for (int x_coord = start_x; ; x_coord += step)
+    {
+        if (is_span_solid(x_coord, x_coord, first_y, last_y))
+        {
+            fixed_t tile_left  = FixedPoint::from_float(m_left_bound) + x_coord * tile_size,
+                    tile_right = tile_left + tile_size;
+            
+            collision.collided   = true;
+            collision.correction = FixedPoint::to_float(move > 0 ? tile_left - edge : tile_right - edge);
+            return collision;
+        }
+        
+        if (x_coord == end_x) break;
+    }
+    
+    return collision;
+}
@@ -14,6 +14,7 @@
 #include <GL/glew.h>
 #endif
 #define GL_GLEXT_PROTOTYPES 1
+#include <cstdint>
 #include <vector>
 #include <math.h>
 #include <SDL.h>
@@ -22,51 +23,194 @@
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
+#include "LevelFile.h"
+#include "FixedPoint.h"
+
+/**
+    A CHUNK_SIZE × CHUNK_SIZE block of tiles with its own vertex buffer. Chunks with no
+    solid tiles never get a buffer. Between prepare() and upload() the chunk's vertices
+    wait in staged_vertices.
+*/
+struct MapChunk
+{
+    GLuint vertex_buffer = 0;
+    int    solid_tiles   = 0;
+    
+    // A streaming map only meshes some chunks; the rest have no buffer and no count.
+    // Dirty chunks have been edited by set_tile(), so their tiles can't be re-read
+    // from the level file.
+    bool is_meshed = true,
+         is_dirty  = false;
+    
+    std::vector<float> staged_vertices;
+};
+
+/**
+    A map built from a chunked LevelFile streams: only the chunks within radius of the
+    view centre are meshed, and once the meshed chunks cost more than budget bytes (GPU
+    vertices plus their tiles) the farthest ones outside the radius are dropped, with
+    their tile pages given back to the OS.
+    
+    Chunks inside the radius are never dropped, so the budget has to hold them all. A
+    budget of 0 is sized from the radius, with one ring of chunks to spare so a view
+    moving back and forth over a chunk border doesn't re-mesh every time; a budget too
+    small for the radius has the radius cut down to fit.
+*/
+struct MapStreamSettings
+{
+    int    radius = 4;
+    size_t budget = 0;
+};
+
+struct MapStreamStats
+{
+    int    resident_chunks = 0;
+    size_t resident_bytes  = 0;
+    int    chunks_meshed   = 0;
+    int    chunks_evicted  = 0;
+    size_t bytes_released  = 0;
+};
+
+/**
+    Result of pushing an AABB out of the map along one axis: add correction to the
+    entity's position on that axis.
+*/
+struct MapCollision
+{
+    bool  collided   = false;
+    float correction = 0.0f;
+};
+
+struct MapRenderStats
+{
+    int chunks_drawn  = 0;
+    int chunks_culled = 0;
+};
 
 class Map {
 private:
     int m_width;
     int m_height;
     
-    // Here, the level_data is the numerical "drawing" of the map
-    unsigned int *m_level_data;
+    // Here, the level_data is the numerical "drawing" of the map, one 16-bit tile id per
+    // cell. The map doesn't own it; it usually points into a mapped LevelFile.
+    uint16_t *m_level_data;
     GLuint m_texture_id;
     
     float m_tile_size;
     int   m_tile_count_x;
     int   m_tile_count_y;
     
-    // Just like with rendering text, we're rendering several sprites at once
-    // So we need vectors to store their respective vertices and texture coordinates
-    std::vector<float> m_vertices;
-    std::vector<float> m_texture_coordinates;
+    // The map lives on the GPU in chunks. Inside a chunk every cell owns one quad (4
+    // interleaved x, y, u, v vertices) at a fixed slot, so changing a tile only rewrites
+    // that slot. Empty cells are written as degenerate quads that rasterise nothing.
+    // Every chunk has the same layout, so they all share one index buffer.
+    std::vector<MapChunk> m_chunks;
+    int    m_chunk_count_x = 0,
+           m_chunk_count_y = 0,
+           m_solid_chunks  = 0;
+    GLuint m_index_buffer  = 0;
+    
+    // What the camera can see, in world space; until it is set every chunk is drawn
+    bool  m_has_view_bounds = false;
+    float m_view_left, m_view_right, m_view_top, m_view_bottom;
+    
+    MapRenderStats m_render_stats;
+    
+    bool m_is_uploaded = false;
+    
+    // ————— STREAMING ————— //
+    LevelFile        *m_level_file = nullptr;
+    int               m_layout_chunk_size = 0;   // 0 when the tiles are row-major
+    bool              m_is_streaming = false;
+    MapStreamSettings m_stream_settings;
+    MapStreamStats    m_stream_stats;
+    std::vector<int>  m_meshed_chunks;
+    
+    int const tile_index(int x_coord, int y_coord) const
+    {
+        if (m_layout_chunk_size == 0) return y_coord * m_width + x_coord;
+        
+        int chunk = (y_coord / CHUNK_SIZE) * m_chunk_count_x + (x_coord / CHUNK_SIZE);
+        return chunk * CHUNK_SIZE * CHUNK_SIZE + (y_coord % CHUNK_SIZE) * CHUNK_SIZE + (x_coord % CHUNK_SIZE);
+    }
+    
+    void fit_stream_budget();
+    void stream(float focus_x, float focus_y);
+    void evict_chunk(int index);
+    void release_chunk_tiles(int index);
+    
+    void write_tile_vertices(int x_coord, int y_coord, float *vertices) const;
+    int  write_chunk_vertices(int chunk_x, int chunk_y, std::vector<float> &vertices) const;
+    void upload_chunk(MapChunk &chunk, const std::vector<float> &vertices);
+    void build_chunk(int chunk_x, int chunk_y);
+    void release_buffers();
+    void draw_chunk(const MapChunk &chunk, ShaderProgram *program);
+    
+    int  const column_of(float x) const;
+    int  const row_of(float y)    const;
+    bool const is_span_solid(int first_x, int last_x, int first_y, int last_y) const;
+    
+    // The same sweeps worked in FixedPoint, for the deterministic simulation mode
+    int          const column_of_fixed(fixed_t x) const;
+    int          const row_of_fixed(fixed_t y)    const;
+    MapCollision const sweep_x_fixed(glm::vec3 position, float width, float height, float sweep) const;
+    MapCollision const sweep_y_fixed(glm::vec3 position, float width, float height, float sweep) const;
     
     // The boundaries of the map
     float m_left_bound, m_right_bound, m_top_bound, m_bottom_bound;
     
 public:
-    // Constructor
-    Map(int width, int height, unsigned int *level_data, GLuint texture_id, float tile_size, int
-    tile_count_x, int tile_count_y);
+    // ————— STATIC VARIABLES ————— //
+    static constexpr int CHUNK_SIZE = 16;
+    
+    // Constructor. With upload = false only the vertex data is built, which needs no GL
+    // context, so it can run on a loader thread; call upload() on the GL thread before
+    // the first render.
+    Map(int width, int height, uint16_t *level_data, GLuint texture_id, float tile_size, int
+    tile_count_x, int tile_count_y, bool upload = true);
+    
+    // Takes everything but the texture from the level file, which has to outlive the map.
+    // A chunked file gives a streaming map.
+    Map(LevelFile *level, GLuint texture_id, bool upload = true, MapStreamSettings streaming = MapStreamSettings());
+    ~Map();
+    
+    // The map owns GL buffers, so it can't be copied
+    Map(const Map&)            = delete;
+    Map& operator=(const Map&) = delete;
     
     // Methods
     void build();
+    void prepare();
+    void upload();
     void render(ShaderProgram *program);
+    void set_tile(int x_coord, int y_coord, uint16_t tile);
+    void set_view_bounds(float left, float right, float top, float bottom);
+    void set_texture_id(GLuint texture_id) { m_texture_id = texture_id; }
     bool is_solid(glm::vec3 position, float *penetration_x, float *penetration_y);
     
+    // Push an AABB centred on position out of the tiles its leading edge crossed while
+    // moving sweep units along one axis this step
+    MapCollision const sweep_x(glm::vec3 position, float width, float height, float sweep) const;
+    MapCollision const sweep_y(glm::vec3 position, float width, float height, float sweep) const;
+    
     // Getters
     int const get_width()  const  { return m_width;  }
     int const get_height() const  { return m_height; }
     
-    unsigned int* const get_level_data() const { return m_level_data; }
-    GLuint        const get_texture_id() const { return m_texture_id; }
+    uint16_t* const get_level_data() const { return m_level_data; }
+    GLuint    const get_texture_id() const { return m_texture_id; }
     
     float const get_tile_size()    const { return m_tile_size;    }
     int   const get_tile_count_x() const { return m_tile_count_x; }
     int   const get_tile_count_y() const { return m_tile_count_y; }
     
-    std::vector<float> const get_vertices()            const { return m_vertices;             }
-    std::vector<float> const get_texture_coordinates() const { return m_texture_coordinates; }
+    int            const get_chunk_count_x() const { return m_chunk_count_x; }
+    int            const get_chunk_count_y() const { return m_chunk_count_y; }
+    MapRenderStats const get_render_stats()  const { return m_render_stats;  }
+    bool           const get_is_uploaded()   const { return m_is_uploaded;   }
+    bool           const get_is_streaming()  const { return m_is_streaming;  }
+    MapStreamStats const get_stream_stats()  const;
     
     float const get_left_bound()   const { return m_left_bound;   }
     float const get_right_bound()  const { return m_right_bound;  }
@@ -0,0 +1,83 @@
+#pragma once
+#include <stdint.h>
+
+/**
+    One timed scope. GPU samples start at the CPU time their scope began, since that's
+    all we know of when the GPU got to them.
+*/
+struct ProfileSample
+{
+    const char *name;
+    uint32_t    frame;
+    uint8_t     depth;
+    bool        is_gpu;
+    int64_t     start_ns,
+                duration_ns;
+};
+
+/**
+    A lightweight frame profiler. PROFILE_SCOPE("name") times the rest of the enclosing
+    block; PROFILE_GPU_SCOPE("name") does the same on the GPU with a timer query, where
+    the driver has them (ARB or EXT timer_query). Every sample lands in a ring buffer
+    holding the last RING_SIZE of them, which write_csv() and write_chrome_trace()
+    (for chrome://tracing or Perfetto) export.
+
+    Call begin_frame() and end_frame() around each pass of the game loop. end_frame()
+    folds the frame's samples into a running average per name, which is what the
+    overlay shows, and collects any GPU results that have come back by then (usually
+    the ones from a frame or two ago).
+
+    Names must be string literals, or otherwise outlive the profiler. Scopes are only
+    recorded on the thread that calls begin_frame(); GPU scopes can't nest.
+*/
+class Profiler
+{
+public:
+    // ————— STATIC VARIABLES ————— //
+    static constexpr int RING_SIZE = 1 << 16;
+
+    // ————— METHODS ————— //
+    // Looks for timer queries; needs the GL context current. Without it GPU scopes do nothing
+    static void init_gpu();
+    static void shutdown_gpu();
+
+    static void begin_frame();
+    static void end_frame();
+
+    static void begin(const char *name);
+    static void end();
+    static void begin_gpu(const char *name);
+    static void end_gpu();
+
+    static bool write_csv(const char *filepath);
+    static bool write_chrome_trace(const char *filepath);
+
+    // ————— GETTERS ————— //
+    // The smoothed time per frame spent in name, and how many names there are to ask
+    // about, in the order they were first seen
+    static float       const get_average_ms(const char *name, bool is_gpu = false);
+    static int         const get_name_count();
+    static const char *const get_name(int index, bool *is_gpu = nullptr);
+
+    static uint32_t const get_frame();
+    static bool     const get_has_gpu_timers();
+};
+
+class ProfileScope
+{
+public:
+    ProfileScope(const char *name) { Profiler::begin(name); }
+    ~ProfileScope()                { Profiler::end();       }
+};
+
+class ProfileGpuScope
+{
+public:
+    ProfileGpuScope(const char *name) { Profiler::begin_gpu(name); }
+    ~ProfileGpuScope()                { Profiler::end_gpu();       }
+};
+
+#define PROFILE_CONCATENATE_INNER(a, b) a ## b
+#define PROFILE_CONCATENATE(a, b)       PROFILE_CONCATENATE_INNER(a, b)
+#define PROFILE_SCOPE(name)     ProfileScope    PROFILE_CONCATENATE(profile_scope_, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) ProfileGpuScope PROFILE_CONCATENATE(profile_gpu_scope_, __LINE__)(name)
@@ -13,8 +13,15 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
 #include "Util.h"
+#include "Utility.h"
 #include "Entity.h"
+#include "EntityStore.h"
 #include "Map.h"
+#include "LevelFile.h"
+#include "SpriteBatch.h"
+#include "InstanceBatch.h"
+#include "SpatialHash.h"
+#include "Input.h"
 
 /**
     Notice that the game's state is now part of the Scene class, not the main file.
@@ -22,9 +29,15 @@
 struct GameState
 {
     // ————— GAME OBJECTS ————— //
+    LevelFile *level;
     Map *map;
     Entity *player;
-    Entity *enemies;
+    EntityStore *enemies;
+    
+    // ————— TEXTURES ————— //
+    TextureHandle map_texture;
+    TextureHandle player_texture;
+    TextureHandle enemy_texture;
     
     // ————— AUDIO ————— //
     Mix_Music *bgm;
@@ -38,18 +51,41 @@ struct GameState
     int next_scene_id;
 };
 
+/**
+    The buttons the game binds its keys to (see Input). main.cpp and the headless tool
+    both drive the game through these, so an input log plays back in either.
+    BUTTON_PROFILER only shows or hides the profiler overlay.
+*/
+enum GameButton { BUTTON_LEFT, BUTTON_RIGHT, BUTTON_JUMP, BUTTON_START, BUTTON_QUIT, BUTTON_PROFILER };
+
 class Scene {
 protected:
     GameState m_game_state;
+    SpriteBatch m_sprite_batch;
+    InstanceBatch m_instance_batch;
+    SpatialHash m_broad_phase;
     
 public:
     // ————— ATTRIBUTES ————— //
     int m_number_of_enemies = 1;
     
+    // ————— DESTRUCTOR ————— //
+    virtual ~Scene() { }
+    
     // ————— METHODS ————— //
+    // Runs before initialise(), possibly on a loader thread: decode and build whatever
+    // doesn't need the GL context, so initialise() is left with only the uploads
+    virtual void preload() { }
     virtual void initialise() = 0;
     virtual void update(float delta_time) = 0;
-    virtual void render(ShaderProgram *program) = 0;
+    
+    // alpha is how far real time has got between the last step and the next, from
+    // StepClock::get_alpha(); moving things are drawn that far from where they were
+    // to where they are
+    virtual void render(ShaderProgram *program, float alpha) = 0;
+    
+    // Scenes that play as the shared player take it here; it stays owned by the caller
+    virtual void set_player(Entity* player) { }
     
     // ————— GETTERS ————— //
     GameState const get_state() const { return m_game_state;             }
@@ -0,0 +1,148 @@
+#include "SceneManager.h"
+#include <chrono>
+#include "LevelA.h"
+#include "LevelB.h"
+#include "LevelC.h"
+#include "Start.h"
+#include "Win.h"
+#include "Lose.h"
+
+// Everything more than one scene loads
+const char *const SHARED_TEXTURES[] = { "assets/tilemap_packed.png", "assets/aiplatformerenemy.png",
+                                       "assets/DinoSprites.png",    "assets/font1.png" };
+
+typedef std::chrono::steady_clock LoadClock;
+
+static float milliseconds_since(LoadClock::time_point start)
+{
+    return std::chrono::duration<float, std::milli>(LoadClock::now() - start).count();
+}
+
+SceneManager::SceneManager(Entity *player) : m_player(player)
+{
+    for (const char *filepath : SHARED_TEXTURES)
+        m_pinned_textures.push_back(Utility::acquire_texture(filepath));
+}
+
+SceneManager::~SceneManager()
+{
+    // The scenes let go of their references first, then the pins free the assets
+    finish_preload();
+    delete m_preloaded_scene;
+    m_preloaded_scene = nullptr;
+    Utility::discard_prefetched_textures();
+    
+    delete m_current_scene;
+    m_current_scene = nullptr;
+    
+    for (TextureHandle &texture : m_pinned_textures) Utility::release_texture(texture);
+}
+
+Scene *SceneManager::create_scene(SceneId scene_id)
+{
+    switch (scene_id)
+    {
+        case START_SCENE:   return new Start();
+        case LEVEL_A_SCENE: return new LevelA();
+        case LEVEL_B_SCENE: return new LevelB();
+        case LEVEL_C_SCENE: return new LevelC();
+        case WIN_SCENE:     return new Win();
+        case LOSE_SCENE:    return new Lose();
+    }
+    
+    return nullptr;
+}
+
+SceneId const SceneManager::get_next_scene_id(SceneId scene_id)
+{
+    switch (scene_id)
+    {
+        case START_SCENE:   return LEVEL_A_SCENE;
+        case LEVEL_A_SCENE: return LEVEL_B_SCENE;
+        case LEVEL_B_SCENE: return LEVEL_C_SCENE;
+        case LEVEL_C_SCENE: return WIN_SCENE;
+        
+        // ENTER on either screen starts over
+        case WIN_SCENE:
+        case LOSE_SCENE:    return LEVEL_A_SCENE;
+    }
+    
+    return LEVEL_A_SCENE;
+}
+
+void SceneManager::finish_preload()
+{
+    if (m_loader.joinable()) m_loader.join();
+}
+
+void SceneManager::preload(SceneId scene_id)
+{
+    finish_preload();
+    
+    if (m_preloaded_scene != nullptr)
+    {
+        if (m_preloaded_scene_id == scene_id) return;
+        
+        delete m_preloaded_scene;
+        m_preloaded_scene = nullptr;
+    }
+    
+    m_preloaded_scene_id = scene_id;
+    m_loader = std::thread([this, scene_id]()
+    {
+        LoadClock::time_point start = LoadClock::now();
+        
+        Scene *scene = create_scene(scene_id);
+        scene->preload();
+        
+        m_preload_ms      = milliseconds_since(start);
+        m_preloaded_scene = scene;
+    });
+}
+
+void SceneManager::switch_to(SceneId scene_id)
+{
+    LoadClock::time_point start = LoadClock::now();
+    
+    SceneLoadTiming timing;
+    timing.scene_id = scene_id;
+    
+    // A loader still running is usually building this very scene; wait for it
+    finish_preload();
+    timing.wait_ms = milliseconds_since(start);
+    
+    Scene *scene = nullptr;
+    
+    if (m_preloaded_scene != nullptr && m_preloaded_scene_id == scene_id)
+    {
+        scene = m_preloaded_scene;
+        timing.was_preloaded = true;
+        timing.preload_ms    = m_preload_ms;
+    }
+    else
+    {
+        delete m_preloaded_scene;
+        
+        LoadClock::time_point preload_start = LoadClock::now();
+        scene = create_scene(scene_id);
+        scene->preload();
+        timing.preload_ms = milliseconds_since(preload_start);
+    }
+    
+    m_preloaded_scene = nullptr;
+    
+    delete m_current_scene;
+    m_current_scene    = scene;
+    m_current_scene_id = scene_id;
+    m_scenes_created++;
+    
+    LoadClock::time_point initialise_start = LoadClock::now();
+    m_current_scene->initialise();
+    m_current_scene->set_player(m_player);
+    timing.initialise_ms = milliseconds_since(initialise_start);
+    
+    timing.switch_ms   = milliseconds_since(start);
+    m_last_load_timing = timing;
+    
+    if (m_is_preloading) preload(get_next_scene_id(scene_id));
+}
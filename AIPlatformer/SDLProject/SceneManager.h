@@ -0,0 +1,86 @@
+#pragma once
+#include <thread>
+#include <vector>
+#include "Scene.h"
+
+enum SceneId { START_SCENE, LEVEL_A_SCENE, LEVEL_B_SCENE, LEVEL_C_SCENE, WIN_SCENE, LOSE_SCENE };
+
+/**
+    How long the last switch_to() took, in milliseconds. preload_ms ran on the loader
+    thread while the previous scene was playing, unless was_preloaded is false, in
+    which case it ran inside the switch. switch_ms is everything the main thread spent
+    in switch_to(): waiting for the loader, freeing the old scene and initialise().
+*/
+struct SceneLoadTiming
+{
+    SceneId scene_id      = START_SCENE;
+    bool    was_preloaded = false;
+    float   preload_ms    = 0.0f,
+            wait_ms       = 0.0f,
+            initialise_ms = 0.0f,
+            switch_ms     = 0.0f;
+};
+
+/**
+    Owns whichever scene is running. Switching deletes the outgoing scene, which frees
+    its map, enemies, text and its references to cached textures and audio. Textures that
+    every scene uses are pinned here for the whole session, so they are never reloaded
+    and the set of live GL objects stays the same however often levels cycle. Audio is
+    kept resident by AudioSystem's bank instead.
+*/
+class SceneManager
+{
+private:
+    Scene  *m_current_scene    = nullptr;
+    SceneId m_current_scene_id = START_SCENE;
+    
+    // ————— LOADER ————— //
+    // The next scene is built and preloaded on m_loader; the main thread only reads
+    // m_preloaded_* after joining it
+    std::thread m_loader;
+    Scene      *m_preloaded_scene    = nullptr;
+    SceneId     m_preloaded_scene_id = START_SCENE;
+    float       m_preload_ms         = 0.0f;
+    bool        m_is_preloading      = true;
+    
+    SceneLoadTiming m_last_load_timing;
+    
+    // The player carried from level to level; owned by whoever made the manager
+    Entity *m_player;
+    
+    // ————— PINNED ASSETS ————— //
+    std::vector<TextureHandle> m_pinned_textures;
+    
+    int m_scenes_created = 0;
+    
+    static Scene *create_scene(SceneId scene_id);
+    void finish_preload();
+    
+public:
+    // ————— CONSTRUCTORS ————— //
+    SceneManager(Entity *player);
+    ~SceneManager();
+    
+    // Needs a GL context and an open AudioSystem
+    SceneManager(const SceneManager&)            = delete;
+    SceneManager& operator=(const SceneManager&) = delete;
+    
+    // ————— METHODS ————— //
+    // Uses the preloaded scene if it's the one asked for, and then starts preloading
+    // whichever scene normally follows this one
+    void switch_to(SceneId scene_id);
+    void preload(SceneId scene_id);
+    
+    static SceneId const get_next_scene_id(SceneId scene_id);
+    
+    // ————— SETTERS ————— //
+    // With preloading off every switch loads synchronously, as before
+    void set_preloading(bool is_preloading) { m_is_preloading = is_preloading; }
+    
+    // ————— GETTERS ————— //
+    Scene  *get_current_scene()    const { return m_current_scene;    }
+    SceneId const get_current_scene_id() const { return m_current_scene_id; }
+    int     const get_scenes_created()   const { return m_scenes_created;   }
+    
+    SceneLoadTiming const get_last_load_timing() const { return m_last_load_timing; }
+};
@@ -0,0 +1,53 @@
+#include "Simulation.h"
+#include "Entity.h"
+#include "EntityStore.h"
+
+static bool g_is_deterministic = false;
+
+// ————— CHECKSUM ————— //
+static void hash_bytes(uint64_t &hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = (const unsigned char *) data;
+    
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+static void hash_vector(uint64_t &hash, glm::vec3 vector)
+{
+    hash_bytes(hash, &vector.x, sizeof(float));
+    hash_bytes(hash, &vector.y, sizeof(float));
+}
+
+uint64_t const Simulation::checksum(int scene_id, const Entity *player, const EntityStore *enemies)
+{
+    uint64_t hash  = 14695981039346656037ull;
+    int      lives = player->get_lives();
+    
+    hash_bytes(hash, &scene_id, sizeof(scene_id));
+    hash_bytes(hash, &lives, sizeof(lives));
+    hash_vector(hash, player->get_position());
+    hash_vector(hash, player->get_velocity());
+    
+    for (int i = 0; i < enemies->get_count(); i++)
+    {
+        hash_vector(hash, enemies->get_position(i));
+        hash_vector(hash, enemies->get_velocity(i));
+    }
+    
+    return hash;
+}
+
+// ————— MODE ————— //
+bool const Simulation::get_is_deterministic()
+{
+    return g_is_deterministic;
+}
+
+void Simulation::set_deterministic(bool is_deterministic)
+{
+    g_is_deterministic = is_deterministic;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+
+class Entity;
+class EntityStore;
+
+/**
+    Settings that change how every entity steps, and a checksum of the result.
+    
+    In deterministic mode the products in the physics (velocity and position
+    integration, overlap and map collision maths, the guard AI's distance test) are
+    worked in FixedPoint instead of float, so a fixed step gives bit-identical state
+    on any build. Entities still keep floats; values are only converted where they're
+    multiplied. Lone float adds and compares are left alone, as IEEE already rounds
+    those the same everywhere.
+    
+    Switch modes between runs, not in the middle of one.
+*/
+class Simulation
+{
+public:
+    // ————— METHODS ————— //
+    // FNV-1a over the raw bits of the scene, the player's lives, position and velocity,
+    // and every enemy's position and velocity, so any divergence at all changes it
+    static uint64_t const checksum(int scene_id, const Entity *player, const EntityStore *enemies);
+    
+    // ————— GETTERS ————— //
+    static bool const get_is_deterministic();
+    
+    // ————— SETTERS ————— //
+    static void set_deterministic(bool is_deterministic);
+};
@@ -0,0 +1,101 @@
+#include "SpatialHash.h"
+#include "EntityStore.h"
+#include <algorithm>
+#include <cmath>
+
+SpatialHash::SpatialHash(float cell_size) : m_cell_size(cell_size) { }
+
+int const SpatialHash::cell_coordinate(float world_coordinate) const
+{
+    return (int) floor(world_coordinate / m_cell_size);
+}
+
+int const SpatialHash::bucket_of(int cell_x, int cell_y) const
+{
+    // Large primes spread neighbouring cells across the table
+    unsigned int hash = ((unsigned int) cell_x * 92837111u) ^ ((unsigned int) cell_y * 689287499u);
+    return (int) (hash % (unsigned int) (m_cell_start.size() - 1));
+}
+
+void SpatialHash::build(const EntityStore &entities)
+{
+    build(entities.get_positions_x(), entities.get_positions_y(), entities.get_widths(), entities.get_heights(),
+          entities.get_count());
+}
+
+void SpatialHash::build(const float *positions_x, const float *positions_y, const float *widths, const float *heights,
+                        int entity_count)
+{
+    // Twice as many buckets as entities keeps most buckets to a single cell
+    int bucket_count = std::max(1, entity_count * 2);
+    
+    m_cell_start.assign(bucket_count + 1, 0);
+    m_cell_entries.resize(entity_count);
+    m_entity_bucket.resize(entity_count);
+    m_query_stamps.resize(entity_count, 0);
+    
+    m_max_half_width  = 0.0f;
+    m_max_half_height = 0.0f;
+    
+    // Count how many entities land in each bucket...
+    for (int i = 0; i < entity_count; i++)
+    {
+        m_entity_bucket[i] = bucket_of(cell_coordinate(positions_x[i]), cell_coordinate(positions_y[i]));
+        m_cell_start[m_entity_bucket[i] + 1]++;
+        
+        m_max_half_width  = std::max(m_max_half_width,  widths[i]  / 2.0f);
+        m_max_half_height = std::max(m_max_half_height, heights[i] / 2.0f);
+    }
+    
+    // ...turn the counts into offsets...
+    for (int bucket = 0; bucket < bucket_count; bucket++)
+        m_cell_start[bucket + 1] += m_cell_start[bucket];
+    
+    // ...and drop each entity into its slot, in index order
+    std::vector<int> &next_slot = m_candidates;
+    next_slot.assign(m_cell_start.begin(), m_cell_start.end() - 1);
+    
+    for (int i = 0; i < entity_count; i++)
+        m_cell_entries[next_slot[m_entity_bucket[i]]++] = i;
+    
+    m_candidates.clear();
+}
+
+const std::vector<int> &SpatialHash::query(glm::vec3 position, float width, float height)
+{
+    m_candidates.clear();
+    if (m_cell_entries.empty()) return m_candidates;
+    
+    // A fresh stamp invalidates every mark left by the previous query
+    if (++m_current_stamp == 0)
+    {
+        std::fill(m_query_stamps.begin(), m_query_stamps.end(), 0);
+        m_current_stamp = 1;
+    }
+    
+    int first_x = cell_coordinate(position.x - width  / 2.0f - m_max_half_width),
+        last_x  = cell_coordinate(position.x + width  / 2.0f + m_max_half_width),
+        first_y = cell_coordinate(position.y - height / 2.0f - m_max_half_height),
+        last_y  = cell_coordinate(position.y + height / 2.0f + m_max_half_height);
+    
+    for (int cell_y = first_y; cell_y <= last_y; cell_y++)
+    {
+        for (int cell_x = first_x; cell_x <= last_x; cell_x++)
+        {
+            int bucket = bucket_of(cell_x, cell_y);
+            
+            for (int slot = m_cell_start[bucket]; slot < m_cell_start[bucket + 1]; slot++)
+            {
+                int index = m_cell_entries[slot];
+                if (m_query_stamps[index] == m_current_stamp) continue;
+                
+                m_query_stamps[index] = m_current_stamp;
+                m_candidates.push_back(index);
+            }
+        }
+    }
+    
+    // Resolve in index order, exactly like the linear loops did
+    std::sort(m_candidates.begin(), m_candidates.end());
+    return m_candidates;
+}
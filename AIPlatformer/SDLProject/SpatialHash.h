@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include "glm/glm.hpp"
+
+class EntityStore;
+
+/**
+    Broad phase for entity-vs-entity collisions. Every entity is filed under the grid
+    cell holding its centre, and cells are hashed into a fixed table that is rebuilt
+    with a counting sort, so a rebuild is O(N) and allocation-free once warmed up.
+    A query returns the indices of entities in the cells around a box, which then go
+    through the usual Entity::check_collision narrow phase.
+*/
+class SpatialHash
+{
+private:
+    float m_cell_size;
+    
+    // Bucket b holds m_cell_entries[m_cell_start[b] .. m_cell_start[b + 1])
+    std::vector<int> m_cell_start;
+    std::vector<int> m_cell_entries;
+    std::vector<int> m_entity_bucket;
+    
+    // Biggest half-extents seen in the last build; queries grow by these so that
+    // entities centred in a neighbouring cell are still found
+    float m_max_half_width  = 0.0f,
+          m_max_half_height = 0.0f;
+    
+    // Different cells can share a bucket, so queries stamp entities to skip repeats
+    std::vector<int> m_query_stamps;
+    int              m_current_stamp = 0;
+    std::vector<int> m_candidates;
+    
+    int const cell_coordinate(float world_coordinate) const;
+    int const bucket_of(int cell_x, int cell_y) const;
+    
+public:
+    // ————— CONSTRUCTORS ————— //
+    SpatialHash(float cell_size = 1.0f);
+    
+    // ————— METHODS ————— //
+    void build(const float *positions_x, const float *positions_y, const float *widths, const float *heights,
+               int entity_count);
+    void build(const EntityStore &entities);
+    const std::vector<int> &query(glm::vec3 position, float width, float height);
+    
+    // ————— GETTERS ————— //
+    float const get_cell_size() const { return m_cell_size; }
+};
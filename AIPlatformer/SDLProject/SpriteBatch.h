@@ -0,0 +1,58 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "ShaderProgram.h"
+
+/**
+    Collects every sprite quad for a frame, then sorts them by texture and draws each
+    texture's quads with a single glDrawArrays out of one persistent vertex buffer.
+    Quads are transformed into world space on the CPU, so the model matrix is set to
+    the identity once per flush instead of once per sprite.
+*/
+class SpriteBatch
+{
+private:
+    struct Quad
+    {
+        GLuint texture_id;
+        int    order;       // submission order, keeps the sort stable
+        float  vertices[24]; // 6 vertices of interleaved x, y, u, v
+    };
+    
+    std::vector<Quad>  m_quads;
+    std::vector<float> m_vertices;
+    
+    GLuint m_vertex_buffer   = 0;
+    size_t m_buffer_capacity = 0; // in bytes
+    
+    int m_draw_calls   = 0,
+        m_sprite_count = 0;
+    
+public:
+    // ————— CONSTRUCTORS ————— //
+    SpriteBatch() = default;
+    ~SpriteBatch();
+    
+    SpriteBatch(const SpriteBatch&)            = delete;
+    SpriteBatch& operator=(const SpriteBatch&) = delete;
+    
+    // ————— METHODS ————— //
+    void begin();
+    void draw(GLuint texture_id, const glm::mat4 &model_matrix, float u_coord, float v_coord, float width, float height);
+    void end(ShaderProgram *program);
+    
+    // ————— GETTERS ————— //
+    // Both describe the last end() call
+    int const get_draw_calls()   const { return m_draw_calls;   }
+    int const get_sprite_count() const { return m_sprite_count; }
+};
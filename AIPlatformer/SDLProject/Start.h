@@ -1,16 +1,20 @@
 #include "Scene.h"
+#include "Text.h"
 
 class Start : public Scene {
-public:
-    // ————— STATIC ATTRIBUTES ————— //
-    int ENEMY_COUNT = 1;
+private:
+    // ————— TEXT ————— //
+    Text *m_title_text  = nullptr;
+    Text *m_prompt_text = nullptr;
     
+public:
     // ————— DESTRUCTOR ————— //
     ~Start();
     
     // ————— METHODS ————— //
+    void preload() override;
     void initialise() override;
     void update(float delta_time) override;
-    void render(ShaderProgram *program) override;
-    void set_player(Entity* player);
+    void render(ShaderProgram *program, float alpha) override;
+    void set_player(Entity* player) override;
 };
@@ -0,0 +1,42 @@
+#include "StepClock.h"
+
+StepClock::StepClock(uint32_t steps_per_second, uint32_t max_steps_per_frame) :
+    m_steps_per_second(steps_per_second)
+{
+    set_max_steps_per_frame(max_steps_per_frame);
+}
+
+uint32_t StepClock::advance(uint32_t ticks)
+{
+    if (!m_is_started)
+    {
+        reset(ticks);
+        return 0;
+    }
+
+    // In 64 bits, so even a very long stall can't wrap the sum
+    uint64_t owed = m_accumulator + (uint64_t) (ticks - m_previous_ticks) * m_steps_per_second;
+    m_previous_ticks = ticks;
+
+    uint64_t steps = owed / STEP_THOUSANDTHS;
+    m_accumulator  = (uint32_t) (owed % STEP_THOUSANDTHS);
+
+    m_stats.frames++;
+
+    if (steps > m_max_steps_per_frame)
+    {
+        m_stats.clamped_frames++;
+        m_stats.dropped_steps += steps - m_max_steps_per_frame;
+        steps = m_max_steps_per_frame;
+    }
+
+    m_stats.steps += steps;
+    return (uint32_t) steps;
+}
+
+void StepClock::reset(uint32_t ticks)
+{
+    m_previous_ticks = ticks;
+    m_accumulator    = 0;
+    m_is_started     = true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+
+struct StepClockStats
+{
+    uint64_t frames         = 0,
+             steps          = 0,     // steps handed out to run
+             clamped_frames = 0,     // frames that owed more than the cap
+             dropped_steps  = 0;     // steps those frames owed past it, never run
+};
+
+/**
+    Turns the wall-clock time between frames into a whole number of fixed steps, keeping
+    the remainder for next frame.
+
+    A frame never gets more than max_steps_per_frame of them. After a stall (a
+    synchronous level load, a debugger pause) the steps owed past the cap are dropped,
+    not run later, so the simulation slows down against real time for that frame
+    instead of spending the next ones catching up, each catch-up frame taking longer
+    and owing more steps still. get_stats() counts how often that happens.
+
+    Time is counted in thousandths of a step, so a millisecond is exactly
+    steps_per_second of them and nothing is lost to rounding however long we run.
+*/
+class StepClock
+{
+public:
+    // ————— STATIC VARIABLES ————— //
+    static constexpr uint32_t STEP_THOUSANDTHS = 1000;
+
+private:
+    uint32_t m_steps_per_second,
+             m_max_steps_per_frame;
+
+    uint32_t m_previous_ticks = 0,
+             m_accumulator    = 0;
+    bool     m_is_started     = false;
+
+    StepClockStats m_stats;
+
+public:
+    // ————— CONSTRUCTORS ————— //
+    StepClock(uint32_t steps_per_second, uint32_t max_steps_per_frame);
+
+    // ————— METHODS ————— //
+    // How many steps to run this frame, given SDL_GetTicks(); the first call only
+    // starts the clock
+    uint32_t advance(uint32_t ticks);
+
+    // Starts the next frame from ticks without owing anything for the time since the
+    // last one, for when the gap is known to be a stall we don't want simulated
+    void reset(uint32_t ticks);
+
+    // ————— GETTERS ————— //
+    // How far the simulation is into the next step, from 0 up to (not including) 1; the
+    // renderer can use it to draw between the last two steps
+    float          const get_alpha()               const { return (float) m_accumulator / STEP_THOUSANDTHS; }
+    float          const get_step_seconds()        const { return 1.0f / m_steps_per_second; }
+    uint32_t       const get_steps_per_second()    const { return m_steps_per_second;    }
+    uint32_t       const get_max_steps_per_frame() const { return m_max_steps_per_frame; }
+    StepClockStats const get_stats()               const { return m_stats;               }
+
+    // ————— SETTERS ————— //
+    void set_max_steps_per_frame(uint32_t max_steps) { m_max_steps_per_frame = max_steps > 0 ? max_steps : 1; }
+    void set_steps_per_second(uint32_t steps_per_second) { m_steps_per_second = steps_per_second > 0 ? steps_per_second : 1; }
+};
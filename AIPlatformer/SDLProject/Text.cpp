@@ -0,0 +1,92 @@
+#define FONTBANK_SIZE      16
+#define VERTICES_PER_CHAR  6
+#define FLOATS_PER_VERTEX  4
+
+#include "Text.h"
+
+Text::Text(const char *font_filepath, const std::string &text, float screen_size, float spacing, glm::vec3 position)
+    : m_text(text), m_screen_size(screen_size), m_spacing(spacing)
+{
+    m_font_texture = Utility::acquire_texture(font_filepath);
+    glGenBuffers(1, &m_vertex_buffer);
+    set_position(position);
+}
+
+Text::~Text()
+{
+    glDeleteBuffers(1, &m_vertex_buffer);
+    Utility::release_texture(m_font_texture);
+}
+
+void Text::set_text(const std::string &text)
+{
+    if (text == m_text) return;
+    
+    m_text     = text;
+    m_is_dirty = true;
+}
+
+void Text::rebuild()
+{
+    float width  = 1.0f / FONTBANK_SIZE;
+    float height = 1.0f / FONTBANK_SIZE;
+    
+    m_vertices.clear();
+    
+    // Same layout as Utility::draw_text, just interleaved into one array
+    for (size_t i = 0; i < m_text.size(); i++)
+    {
+        int   spritesheet_index = (int) m_text[i];
+        float offset            = (m_screen_size + m_spacing) * i;
+        
+        float u_coordinate = (float) (spritesheet_index % FONTBANK_SIZE) / FONTBANK_SIZE;
+        float v_coordinate = (float) (spritesheet_index / FONTBANK_SIZE) / FONTBANK_SIZE;
+        
+        float left   = offset + (-0.5f * m_screen_size),
+              right  = offset + ( 0.5f * m_screen_size),
+              top    =  0.5f * m_screen_size,
+              bottom = -0.5f * m_screen_size;
+        
+        m_vertices.insert(m_vertices.end(), {
+            left,  top,    u_coordinate,         v_coordinate,
+            left,  bottom, u_coordinate,         v_coordinate + height,
+            right, top,    u_coordinate + width, v_coordinate,
+            right, bottom, u_coordinate + width, v_coordinate + height,
+            right, top,    u_coordinate + width, v_coordinate,
+            left,  bottom, u_coordinate,         v_coordinate + height,
+        });
+    }
+    
+    m_vertex_count = (int) m_text.size() * VERTICES_PER_CHAR;
+    
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(float), m_vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    
+    m_is_dirty = false;
+}
+
+void Text::render(ShaderProgram *program)
+{
+    if (m_is_dirty) rebuild();
+    if (m_vertex_count == 0) return;
+    
+    program->set_model_matrix(m_model_matrix);
+    
+    GLsizei stride = FLOATS_PER_VERTEX * sizeof(float);
+    
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer);
+    glVertexAttribPointer(program->get_position_attribute(), 2, GL_FLOAT, false, stride, (void*) 0);
+    glEnableVertexAttribArray(program->get_position_attribute());
+    glVertexAttribPointer(program->get_tex_coordinate_attribute(), 2, GL_FLOAT, false, stride, (void*) (2 * sizeof(float)));
+    glEnableVertexAttribArray(program->get_tex_coordinate_attribute());
+    
+    glBindTexture(GL_TEXTURE_2D, m_font_texture.id);
+    glDrawArrays(GL_TRIANGLES, 0, m_vertex_count);
+    
+    glDisableVertexAttribArray(program->get_position_attribute());
+    glDisableVertexAttribArray(program->get_tex_coordinate_attribute());
+    
+    // Everything else still draws from client-side arrays
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
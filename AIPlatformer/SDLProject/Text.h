@@ -0,0 +1,62 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "ShaderProgram.h"
+#include "Utility.h"
+
+/**
+    Retained version of Utility::draw_text. The string's quads are built once into a
+    vertex buffer and only rebuilt when the text changes, so a static label costs one
+    bind and one draw call per frame.
+*/
+class Text
+{
+private:
+    // ————— FONT ————— //
+    TextureHandle m_font_texture;
+    
+    // ————— LAYOUT ————— //
+    std::string m_text;
+    float       m_screen_size,
+                m_spacing;
+    glm::mat4   m_model_matrix;
+    
+    // ————— GEOMETRY ————— //
+    // Interleaved x, y, u, v per vertex; kept around so rebuilds reuse its capacity
+    std::vector<float> m_vertices;
+    GLuint m_vertex_buffer = 0;
+    int    m_vertex_count  = 0;
+    bool   m_is_dirty      = true;
+    
+    void rebuild();
+    
+public:
+    // ————— CONSTRUCTORS ————— //
+    Text(const char *font_filepath, const std::string &text, float screen_size, float spacing, glm::vec3 position);
+    ~Text();
+    
+    // A Text owns a GL buffer and a texture reference, so it can't be copied
+    Text(const Text&)            = delete;
+    Text& operator=(const Text&) = delete;
+    
+    // ————— METHODS ————— //
+    void render(ShaderProgram *program);
+    
+    // ————— GETTERS ————— //
+    std::string const &get_text() const { return m_text; }
+    
+    // ————— SETTERS ————— //
+    void set_text(const std::string &text);
+    void set_position(glm::vec3 position) { m_model_matrix = glm::translate(glm::mat4(1.0f), position); }
+};
@@ -0,0 +1,211 @@
+#define LOG(argument) std::cout << argument << '\n'
+#define BYTES_PER_PIXEL 4
+
+#include "TextureAtlas.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include "stb_image.h"
+#include "TextureFile.h"
+
+static int next_power_of_two(int value)
+{
+    int power = 1;
+    while (power < value) power *= 2;
+
+    return power;
+}
+
+// ————— CONSTRUCTORS ————— //
+TextureAtlas::TextureAtlas(int page_size, int padding) : m_page_size(page_size), m_padding(padding) { }
+
+TextureAtlas::~TextureAtlas()
+{
+    for (Page &page : m_pages) if (page.texture_id != 0) glDeleteTextures(1, &page.texture_id);
+}
+
+// ————— METHODS ————— //
+void TextureAtlas::add(const std::string &name, const unsigned char *pixels, int width, int height)
+{
+    if (m_is_built) return;
+
+    PackedImage image;
+    image.name   = name;
+    image.width  = width;
+    image.height = height;
+    image.pixels.assign(pixels, pixels + (size_t) width * height * BYTES_PER_PIXEL);
+
+    m_images.push_back(std::move(image));
+}
+
+bool TextureAtlas::add(const char *filepath)
+{
+    // A precompiled copy (see TextureFile) has nothing left to decode
+    TextureFile file(filepath);
+    if (file.get_is_loaded())
+    {
+        add(filepath, file.get_pixels(), file.get_width(), file.get_height());
+        return true;
+    }
+
+    int width, height, number_of_components;
+    unsigned char *pixels = stbi_load(filepath, &width, &height, &number_of_components, STBI_rgb_alpha);
+
+    if (pixels == NULL)
+    {
+        LOG("Unable to load image " << filepath << " into the atlas.");
+        return false;
+    }
+
+    add(filepath, pixels, width, height);
+    stbi_image_free(pixels);
+
+    return true;
+}
+
+// Shelf packing: tallest first, left to right, and a new shelf (or page) when a row fills
+void TextureAtlas::place_images()
+{
+    std::vector<PackedImage*> order;
+    for (PackedImage &image : m_images) order.push_back(&image);
+
+    std::stable_sort(order.begin(), order.end(), [](const PackedImage *a, const PackedImage *b) {
+        return a->height != b->height ? a->height > b->height : a->width > b->width;
+    });
+
+    int shelf_x = 0, shelf_y = 0, shelf_height = 0;
+    int page    = -1;
+
+    for (PackedImage *image : order)
+    {
+        int padded_width  = image->width  + 2 * m_padding,
+            padded_height = image->height + 2 * m_padding;
+
+        // Too big to share a page
+        if (padded_width > m_page_size || padded_height > m_page_size)
+        {
+            Page own;
+            own.width  = next_power_of_two(padded_width);
+            own.height = next_power_of_two(padded_height);
+            m_pages.push_back(own);
+
+            image->page = (int) m_pages.size() - 1;
+            image->x    = m_padding;
+            image->y    = m_padding;
+
+            // The page being filled stays open for the next image
+            continue;
+        }
+
+        if (page >= 0 && shelf_x + padded_width > m_page_size)
+        {
+            shelf_y      += shelf_height;
+            shelf_x       = 0;
+            shelf_height  = 0;
+        }
+
+        if (page < 0 || shelf_y + padded_height > m_page_size)
+        {
+            m_pages.push_back(Page());
+            page    = (int) m_pages.size() - 1;
+            shelf_x = shelf_y = shelf_height = 0;
+        }
+
+        image->page = page;
+        image->x    = shelf_x + m_padding;
+        image->y    = shelf_y + m_padding;
+
+        shelf_x      += padded_width;
+        shelf_height  = std::max(shelf_height, padded_height);
+
+        m_pages[page].width  = std::max(m_pages[page].width,  next_power_of_two(shelf_x));
+        m_pages[page].height = std::max(m_pages[page].height, next_power_of_two(shelf_y + shelf_height));
+    }
+}
+
+void TextureAtlas::upload_page(int page)
+{
+    Page &target = m_pages[page];
+    std::vector<unsigned char> pixels((size_t) target.width * target.height * BYTES_PER_PIXEL, 0);
+
+    for (const PackedImage &image : m_images)
+    {
+        if (image.page != page) continue;
+
+        // Each row of the padded rectangle reads the image row nearest to it, and each
+        // pixel the nearest column, which copies the edges out into the padding
+        for (int row = -m_padding; row < image.height + m_padding; row++)
+        {
+            int source_row = std::min(std::max(row, 0), image.height - 1);
+
+            for (int column = -m_padding; column < image.width + m_padding; column++)
+            {
+                int source_column = std::min(std::max(column, 0), image.width - 1);
+
+                const unsigned char *source = &image.pixels[((size_t) source_row * image.width + source_column) * BYTES_PER_PIXEL];
+                unsigned char *destination  = &pixels[((size_t) (image.y + row) * target.width + image.x + column) * BYTES_PER_PIXEL];
+                memcpy(destination, source, BYTES_PER_PIXEL);
+            }
+        }
+    }
+
+    glGenTextures(1, &target.texture_id);
+    glBindTexture(GL_TEXTURE_2D, target.texture_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, target.width, target.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+void TextureAtlas::build()
+{
+    if (m_is_built) return;
+    m_is_built = true;
+
+    place_images();
+    for (int page = 0; page < (int) m_pages.size(); page++) upload_page(page);
+
+    for (PackedImage &image : m_images)
+    {
+        const Page &page = m_pages[image.page];
+
+        image.sprite.texture_id    = page.texture_id;
+        image.sprite.width         = image.width;
+        image.sprite.height        = image.height;
+        image.sprite.region.u      = (float) image.x      / page.width;
+        image.sprite.region.v      = (float) image.y      / page.height;
+        image.sprite.region.width  = (float) image.width  / page.width;
+        image.sprite.region.height = (float) image.height / page.height;
+
+        // The GPU has them now
+        std::vector<unsigned char>().swap(image.pixels);
+    }
+}
+
+const AtlasSprite *TextureAtlas::find(const std::string &name) const
+{
+    if (!m_is_built) return nullptr;
+
+    for (const PackedImage &image : m_images) if (image.name == name) return &image.sprite;
+
+    return nullptr;
+}
+
+// ————— GETTERS ————— //
+size_t const TextureAtlas::get_page_bytes() const
+{
+    size_t bytes = 0;
+    for (const Page &page : m_pages) bytes += (size_t) page.width * page.height * BYTES_PER_PIXEL;
+
+    return bytes;
+}
+
+bool const TextureAtlas::owns_texture(GLuint texture_id) const
+{
+    for (const Page &page : m_pages) if (page.texture_id == texture_id && texture_id != 0) return true;
+
+    return false;
+}
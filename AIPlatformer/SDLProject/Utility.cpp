@@ -4,21 +4,95 @@
 #define LEVEL_OF_DETAIL    0
 #define TEXTURE_BORDER     0
 #define FONTBANK_SIZE      16
+#define BYTES_PER_PIXEL    4
 
 #include "Utility.h"
 #include <SDL_image.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include "stb_image.h"
+#include "TextureFile.h"
 
-GLuint Utility::load_texture(const char* filepath) {
-    int width, height, number_of_components;
-    unsigned char* image = stbi_load(filepath, &width, &height, &number_of_components, STBI_rgb_alpha);
+// ————— TEXTURE CACHE ————— //
+struct TextureCacheEntry
+{
+    TextureHandle handle;
+    int           reference_count;
+};
+
+// Pixels a loader thread decoded ahead of time, waiting for their GL upload. When file
+// is set they're its mapping rather than stb_image's, and deleting it frees them.
+struct DecodedImage
+{
+    const unsigned char *pixels;
+    int                  width,
+                         height;
+    TextureFile         *file = nullptr;
+};
+
+static std::unordered_map<std::string, TextureCacheEntry> g_texture_cache;
+static std::unordered_map<GLuint, std::string>            g_texture_paths;
+static std::unordered_map<std::string, DecodedImage>      g_prefetched_images;
+static TextureCacheStats                                  g_texture_cache_stats;
+
+// Counted outside the lock, since decode_image() runs on loader threads
+static std::atomic<int> g_precompiled_loads(0),
+                        g_decoded_loads(0);
+
+// Images packed by pack_textures(), handed out without reference counting: the atlas
+// holds them all until unpack_textures()
+static TextureAtlas                                  *g_atlas = nullptr;
+static std::unordered_map<std::string, TextureHandle> g_packed_textures;
+
+// prefetch_texture() is the only call made off the GL thread; everything it shares
+// with the rest of the cache is touched under this lock
+static std::mutex g_texture_cache_mutex;
+
+static DecodedImage decode_image(const char* filepath)
+{
+    DecodedImage image;
     
-    if (image == NULL)
+    // A fresh .texcache (see TextureFile) is already decoded, so stb_image is only the
+    // fallback for images the converter hasn't been run on, or that changed since
+    TextureFile *file = new TextureFile(filepath);
+    if (file->get_is_loaded())
+    {
+        image.pixels = file->get_pixels();
+        image.width  = file->get_width();
+        image.height = file->get_height();
+        image.file   = file;
+        
+        g_precompiled_loads++;
+        return image;
+    }
+    delete file;
+    
+    int number_of_components;
+    image.pixels = stbi_load(filepath, &image.width, &image.height, &number_of_components, STBI_rgb_alpha);
+    
+    if (image.pixels == NULL)
     {
         LOG("Unable to load image. Make sure the path is correct.");
         assert(false);
     }
     
+    g_decoded_loads++;
+    return image;
+}
+
+static void free_image(DecodedImage &image)
+{
+    if (image.file != nullptr) delete image.file;
+    else                       stbi_image_free((void *) image.pixels);
+    
+    image.pixels = nullptr;
+    image.file   = nullptr;
+}
+
+static GLuint upload_image(const unsigned char *image, int width, int height)
+{
     GLuint texture_id;
     glGenTextures(NUMBER_OF_TEXTURES, &texture_id);
     glBindTexture(GL_TEXTURE_2D, texture_id);
@@ -30,11 +104,297 @@ GLuint Utility::load_texture(const char* filepath) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     
-    stbi_image_free(image);
+    return texture_id;
+}
+
+static GLuint load_texture_with_size(const char* filepath, int *width, int *height)
+{
+    DecodedImage image = decode_image(filepath);
+    GLuint texture_id = upload_image(image.pixels, image.width, image.height);
+    
+    *width  = image.width;
+    *height = image.height;
+    free_image(image);
     
     return texture_id;
 }
 
+GLuint Utility::load_texture(const char* filepath) {
+    int width, height;
+    return load_texture_with_size(filepath, &width, &height);
+}
+
+TextureHandle Utility::acquire_texture(const char* filepath)
+{
+    std::lock_guard<std::mutex> lock(g_texture_cache_mutex);
+    
+    auto packed = g_packed_textures.find(filepath);
+    if (packed != g_packed_textures.end())
+    {
+        g_texture_cache_stats.hits++;
+        return packed->second;
+    }
+    
+    // Already resident: just bump the reference count
+    auto cached = g_texture_cache.find(filepath);
+    if (cached != g_texture_cache.end())
+    {
+        cached->second.reference_count++;
+        g_texture_cache_stats.hits++;
+        return cached->second.handle;
+    }
+    
+    // Otherwise upload it once, and remember it under its path. If a loader thread has
+    // already decoded it only the upload is left to do here.
+    TextureCacheEntry entry;
+    entry.reference_count = 1;
+    
+    auto prefetched = g_prefetched_images.find(filepath);
+    if (prefetched != g_prefetched_images.end())
+    {
+        DecodedImage image = prefetched->second;
+        g_prefetched_images.erase(prefetched);
+        
+        entry.handle.id     = upload_image(image.pixels, image.width, image.height);
+        entry.handle.width  = image.width;
+        entry.handle.height = image.height;
+        free_image(image);
+        
+        g_texture_cache_stats.prefetch_hits++;
+    }
+    else
+    {
+        entry.handle.id = load_texture_with_size(filepath, &entry.handle.width, &entry.handle.height);
+    }
+    
+    g_texture_cache[filepath]        = entry;
+    g_texture_paths[entry.handle.id] = filepath;
+    
+    g_texture_cache_stats.misses++;
+    g_texture_cache_stats.resident_textures++;
+    g_texture_cache_stats.resident_bytes += (size_t) entry.handle.width * entry.handle.height * BYTES_PER_PIXEL;
+    
+    return entry.handle;
+}
+
+void Utility::release_texture(TextureHandle &handle)
+{
+    if (!handle.is_valid()) return;
+    
+    std::lock_guard<std::mutex> lock(g_texture_cache_mutex);
+    
+    if (g_atlas != nullptr && g_atlas->owns_texture(handle.id))
+    {
+        handle = TextureHandle();
+        return;
+    }
+    
+    auto path = g_texture_paths.find(handle.id);
+    if (path == g_texture_paths.end())
+    {
+        LOG("Released a texture that the cache does not own.");
+        return;
+    }
+    
+    TextureCacheEntry &entry = g_texture_cache[path->second];
+    
+    // The last owner frees the GL texture
+    if (--entry.reference_count == 0)
+    {
+        g_texture_cache_stats.resident_textures--;
+        g_texture_cache_stats.resident_bytes -= (size_t) entry.handle.width * entry.handle.height * BYTES_PER_PIXEL;
+        
+        glDeleteTextures(NUMBER_OF_TEXTURES, &entry.handle.id);
+        g_texture_cache.erase(path->second);
+        g_texture_paths.erase(path);
+    }
+    
+    handle = TextureHandle();
+}
+
+TextureCacheStats const Utility::get_texture_cache_stats()
+{
+    std::lock_guard<std::mutex> lock(g_texture_cache_mutex);
+    
+    TextureCacheStats stats = g_texture_cache_stats;
+    stats.precompiled_loads = g_precompiled_loads;
+    stats.decoded_loads     = g_decoded_loads;
+    
+    return stats;
+}
+
+void Utility::prefetch_texture(const char* filepath)
+{
+    {
+        std::lock_guard<std::mutex> lock(g_texture_cache_mutex);
+        if (g_texture_cache.count(filepath) > 0 || g_prefetched_images.count(filepath) > 0) return;
+        if (g_packed_textures.count(filepath) > 0) return;
+    }
+    
+    // Decoding is the slow part, so it happens without holding the lock
+    DecodedImage image = decode_image(filepath);
+    
+    std::lock_guard<std::mutex> lock(g_texture_cache_mutex);
+    
+    // Someone got there first while we were decoding
+    if (g_texture_cache.count(filepath) > 0 || g_prefetched_images.count(filepath) > 0)
+    {
+        free_image(image);
+        return;
+    }
+    
+    g_prefetched_images[filepath] = image;
+}
+
+void Utility::discard_prefetched_textures()
+{
+    std::lock_guard<std::mutex> lock(g_texture_cache_mutex);
+    
+    for (auto &prefetched : g_prefetched_images) free_image(prefetched.second);
+    g_prefetched_images.clear();
+}
+
+void Utility::pack_textures(const char *const *filepaths, int count)
+{
+    std::lock_guard<std::mutex> lock(g_texture_cache_mutex);
+    if (g_atlas != nullptr) return;
+    
+    g_atlas = new TextureAtlas();
+    
+    for (int i = 0; i < count; i++)
+    {
+        // Pixels a loader thread already decoded save decoding them again
+        DecodedImage image;
+        
+        auto prefetched = g_prefetched_images.find(filepaths[i]);
+        if (prefetched != g_prefetched_images.end())
+        {
+            image = prefetched->second;
+            g_prefetched_images.erase(prefetched);
+        }
+        else image = decode_image(filepaths[i]);
+        
+        g_atlas->add(filepaths[i], image.pixels, image.width, image.height);
+        free_image(image);
+    }
+    
+    g_atlas->build();
+    
+    for (int i = 0; i < count; i++)
+    {
+        const AtlasSprite *sprite = g_atlas->find(filepaths[i]);
+        if (sprite == nullptr) continue;
+        
+        TextureHandle handle;
+        handle.id     = sprite->texture_id;
+        handle.width  = sprite->width;
+        handle.height = sprite->height;
+        handle.region = sprite->region;
+        
+        g_packed_textures[filepaths[i]] = handle;
+    }
+    
+    g_texture_cache_stats.resident_textures += g_atlas->get_page_count();
+    g_texture_cache_stats.resident_bytes    += g_atlas->get_page_bytes();
+    
+    LOG("Packed " << g_atlas->get_image_count() << " textures into " << g_atlas->get_page_count() << " atlas page(s)");
+}
+
+void Utility::unpack_textures()
+{
+    std::lock_guard<std::mutex> lock(g_texture_cache_mutex);
+    if (g_atlas == nullptr) return;
+    
+    g_texture_cache_stats.resident_textures -= g_atlas->get_page_count();
+    g_texture_cache_stats.resident_bytes    -= g_atlas->get_page_bytes();
+    
+    delete g_atlas;
+    g_atlas = nullptr;
+    g_packed_textures.clear();
+}
+
+// ————— AUDIO CACHE ————— //
+template <typename Clip>
+struct AudioCacheEntry
+{
+    Clip *clip;
+    int   reference_count;
+};
+
+static std::unordered_map<std::string, AudioCacheEntry<Mix_Music>> g_music_cache;
+static std::unordered_map<std::string, AudioCacheEntry<Mix_Chunk>> g_sound_cache;
+static std::unordered_map<const void*, std::string>                g_audio_paths;
+
+template <typename Clip, typename Load>
+static Clip *acquire_clip(std::unordered_map<std::string, AudioCacheEntry<Clip>> &cache, const char* filepath, Load load)
+{
+    auto cached = cache.find(filepath);
+    if (cached != cache.end())
+    {
+        cached->second.reference_count++;
+        return cached->second.clip;
+    }
+    
+    Clip *clip = load(filepath);
+    if (clip == nullptr)
+    {
+        LOG("Unable to load audio " << filepath << ": " << Mix_GetError());
+        return nullptr;
+    }
+    
+    cache[filepath]     = { clip, 1 };
+    g_audio_paths[clip] = filepath;
+    
+    return clip;
+}
+
+template <typename Clip, typename Free>
+static void release_clip(std::unordered_map<std::string, AudioCacheEntry<Clip>> &cache, Clip *&clip, Free free)
+{
+    if (clip == nullptr) return;
+    
+    auto path = g_audio_paths.find(clip);
+    if (path == g_audio_paths.end())
+    {
+        LOG("Released audio that the cache does not own.");
+        return;
+    }
+    
+    if (--cache[path->second].reference_count == 0)
+    {
+        free(clip);
+        cache.erase(path->second);
+        g_audio_paths.erase(path);
+    }
+    
+    clip = nullptr;
+}
+
+Mix_Music *Utility::acquire_music(const char* filepath)
+{
+    return acquire_clip(g_music_cache, filepath, [](const char* path) { return Mix_LoadMUS(path); });
+}
+
+Mix_Chunk *Utility::acquire_sound(const char* filepath)
+{
+    return acquire_clip(g_sound_cache, filepath, [](const char* path) { return Mix_LoadWAV(path); });
+}
+
+void Utility::release_music(Mix_Music *&music)
+{
+    release_clip(g_music_cache, music, [](Mix_Music *clip) { Mix_FreeMusic(clip); });
+}
+
+void Utility::release_sound(Mix_Chunk *&sound)
+{
+    release_clip(g_sound_cache, sound, [](Mix_Chunk *clip) { Mix_FreeChunk(clip); });
+}
+
+int const Utility::get_resident_audio_count()
+{
+    return (int) g_audio_paths.size();
+}
+
 void Utility::draw_text(ShaderProgram *program, GLuint font_texture_id, std::string text, float screen_size, float spacing, glm::vec3 position)
 {
     float width = 1.0f / FONTBANK_SIZE;
@@ -79,7 +439,7 @@ void Utility::draw_text(ShaderProgram *program, GLuint font_texture_id, std::str
     model_matrix = glm::translate(model_matrix, position);
     
     program->set_model_matrix(model_matrix);
-    glUseProgram(program->get_program_id());
+    program->use();
     
     glVertexAttribPointer(program->get_position_attribute(), 2, GL_FLOAT, false, 0, vertices.data());
     glEnableVertexAttribArray(program->get_position_attribute());
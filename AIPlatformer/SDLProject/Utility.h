@@ -8,14 +8,69 @@
 #define GL_GLEXT_PROTOTYPES 1
 #include <vector>
 #include <SDL.h>
+#include <SDL_mixer.h>
 #include <SDL_opengl.h>
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
+#include "TextureAtlas.h"
+
+/**
+    A reference to a texture owned by the shared texture cache. Every handle that
+    comes out of acquire_texture() has to go back through release_texture().
+    
+    For an image that was packed into the atlas, id is the atlas page and region is
+    where on it the image is; whatever draws it has to map its texture coordinates
+    through the region.
+*/
+struct TextureHandle
+{
+    GLuint      id     = 0;
+    int         width  = 0,
+                height = 0;
+    AtlasRegion region;
+    
+    bool const is_valid() const { return id != 0; }
+};
+
+struct TextureCacheStats
+{
+    int    hits              = 0;
+    int    misses            = 0;
+    int    prefetch_hits     = 0;   // misses whose pixels a loader thread had already decoded
+    int    precompiled_loads = 0;   // images read from a .texcache instead of decoded
+    int    decoded_loads     = 0;   // images stb_image had to decode
+    int    resident_textures = 0;
+    size_t resident_bytes    = 0;
+};
 
 class Utility {
 public:
     // ————— METHODS ————— //
     static GLuint load_texture(const char* filepath);
     static void draw_text(ShaderProgram *program, GLuint font_texture_id, std::string text, float screen_size, float spacing, glm::vec3 position);
+    
+    // ————— TEXTURE CACHE ————— //
+    static TextureHandle acquire_texture(const char* filepath);
+    static void release_texture(TextureHandle &handle);
+    static TextureCacheStats const get_texture_cache_stats();
+    
+    // Safe to call from any thread: decodes the image so that a later acquire_texture()
+    // on the GL thread only has to upload it. Does nothing if it's already resident.
+    static void prefetch_texture(const char* filepath);
+    static void discard_prefetched_textures();
+    
+    // Packs these images into one atlas (see TextureAtlas); from then on acquire_texture()
+    // answers for them with the atlas page and their region on it, and they stay resident
+    // until unpack_textures(). Call before anything acquires them.
+    static void pack_textures(const char *const *filepaths, int count);
+    static void unpack_textures();
+    
+    // ————— AUDIO CACHE ————— //
+    // Same idea as the texture cache: one decoded copy per path, freed by the last release
+    static Mix_Music *acquire_music(const char* filepath);
+    static Mix_Chunk *acquire_sound(const char* filepath);
+    static void release_music(Mix_Music *&music);
+    static void release_sound(Mix_Chunk *&sound);
+    static int const get_resident_audio_count();
 };
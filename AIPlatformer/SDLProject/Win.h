@@ -1,15 +1,18 @@
 #include "Scene.h"
+#include "Text.h"
 
 class Win : public Scene {
-public:
-    // ————— STATIC ATTRIBUTES ————— //
-    int ENEMY_COUNT = 1;
+private:
+    // ————— TEXT ————— //
+    Text *m_message_text = nullptr;
     
+public:
     // ————— DESTRUCTOR ————— //
     ~Win();
     
     // ————— METHODS ————— //
+    void preload() override;
     void initialise() override;
     void update(float delta_time) override;
-    void render(ShaderProgram *program) override;
+    void render(ShaderProgram *program, float alpha) override;
 };
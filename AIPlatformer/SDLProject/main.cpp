@@ -4,6 +4,7 @@
 #define LEVEL1_WIDTH 14
 #define LEVEL1_HEIGHT 8
 #define LEVEL1_LEFT_EDGE 5.0f
+#define LOG(argument) std::cout << argument << '\n'
 
 #ifdef _WINDOWS
 #include <GL/glew.h>
@@ -17,17 +18,23 @@
 #include "ShaderProgram.h"
 #include "cmath"
 #include <ctime>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
 #include <vector>
 #include "Entity.h"
 #include "Map.h"
 #include "Utility.h"
 #include "Scene.h"
-#include "LevelA.h"
-#include "LevelB.h"
-#include "LevelC.h"
-#include "Start.h"
-#include "Win.h"
-#include "Lose.h"
+#include "SceneManager.h"
+#include "AudioSystem.h"
+#include "Simulation.h"
+#include "Input.h"
+#include "StepClock.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "InstanceBatch.h"
+#include "Text.h"
 
 
 
@@ -47,21 +54,39 @@ constexpr int VIEWPORT_X = 0,
           VIEWPORT_HEIGHT = WINDOW_HEIGHT;
 
 constexpr char V_SHADER_PATH[] = "shaders/vertex_textured.glsl",
-           F_SHADER_PATH[] = "shaders/fragment_textured.glsl";
-
-constexpr float MILLISECONDS_IN_SECOND = 1000.0;
+           F_SHADER_PATH[] = "shaders/fragment_textured.glsl",
+           FONT_FILEPATH[] = "assets/font1.png";
+
+// The sprites drawn every level share one atlas page, so the player and the enemies
+// never switch textures between them. Tilesets and the font keep their own textures:
+// they tile, or index their whole texture.
+const char *const PACKED_TEXTURES[] = { "assets/DinoSprites.png", "assets/aiplatformerenemy.png" };
+
+// After a stall a frame runs at most MAX_STEPS_PER_FRAME steps (~83 ms) and drops the
+// rest; override with --max-steps-per-frame <steps>
+constexpr Uint32 STEPS_PER_SECOND    = 60,
+                 MAX_STEPS_PER_FRAME = 5;
+
+// 512 frames at 44.1 kHz is ~12 ms of mixer latency; override with --audio-buffer <frames>
+constexpr int AUDIO_FREQUENCY    = 44100,
+              AUDIO_CHANNELS     = 2,
+              AUDIO_BUFFER_SIZE  = 512,
+              PLAYER_START_LIVES = 3;
+
+// The overlay lists this many timers, top left, and re-reads them every
+// PROFILER_REFRESH_FRAMES frames so the numbers stay readable
+constexpr int   PROFILER_LINE_COUNT     = 12,
+                PROFILER_REFRESH_FRAMES = 15;
+constexpr float PROFILER_FONT_SIZE      = 0.2f,
+                PROFILER_LINE_HEIGHT    = 0.25f;
 
 enum AppStatus { RUNNING, TERMINATED };
 
 // ————— GLOBAL VARIABLES ————— //
 Scene *g_current_scene;
-LevelA *g_level_a;
-LevelB *g_level_b;
-LevelC *g_level_c;
-Start *g_start;
-Win *g_win;
-Lose *g_lose;
+SceneManager *g_scene_manager = nullptr;
 Entity* g_player = nullptr;
+TextureHandle g_player_texture;
 
 
 
@@ -73,19 +98,40 @@ AppStatus g_app_status = RUNNING;
 ShaderProgram g_shader_program;
 glm::mat4 g_view_matrix, g_projection_matrix;
 
-float g_previous_ticks = 0.0f;
-float g_accumulator = 0.0f;
+StepClock g_step_clock(STEPS_PER_SECOND, MAX_STEPS_PER_FRAME);
+float     g_fixed_timestep = FIXED_TIMESTEP;
+
+int g_audio_buffer_size = AUDIO_BUFFER_SIZE;
+int g_job_workers       = -1;
+
+Input g_input;
 
-void switch_to_scene(Scene *scene)
+// ————— PROFILER ————— //
+bool               g_is_profiler_shown  = false;
+std::vector<Text*> g_profiler_lines;
+const char        *g_profile_csv_path   = nullptr,
+                  *g_profile_trace_path = nullptr;
+
+void switch_to_scene(SceneId scene_id)
 {
-    g_current_scene = scene;
-    g_current_scene->initialise();
+    g_scene_manager->switch_to(scene_id);
+    g_current_scene = g_scene_manager->get_current_scene();
+    
+    // However long that took isn't owed to the simulation
+    g_step_clock.reset(SDL_GetTicks());
+    
+    SceneLoadTiming timing = g_scene_manager->get_last_load_timing();
+    std::cout << "Scene " << scene_id << " ready in " << timing.switch_ms << " ms ("
+              << (timing.was_preloaded ? "preloaded in " : "loaded in ") << timing.preload_ms << " ms, "
+              << "waited " << timing.wait_ms << " ms, initialised in " << timing.initialise_ms << " ms)" << std::endl;
 }
 
 void initialise();
 void process_input();
+void apply_input(const InputSnapshot &input);
 void update();
 void render();
+void render_profiler();
 void shutdown();
 
 
@@ -109,6 +155,8 @@ void initialise()
     glewInit();
 #endif
     
+    Profiler::init_gpu();
+    
     // ————— GENERAL ————— //
     glViewport(VIEWPORT_X, VIEWPORT_Y, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
     
@@ -117,14 +165,15 @@ void initialise()
     g_view_matrix = glm::mat4(1.0f);
     g_projection_matrix = glm::ortho(-5.0f, 5.0f, -3.75f, 3.75f, -1.0f, 1.0f);
     
-    g_shader_program.set_projection_matrix(g_projection_matrix);
-    g_shader_program.set_view_matrix(g_view_matrix);
-
-    glUseProgram(g_shader_program.get_program_id());
+    g_shader_program.set_view_projection_matrix(g_view_matrix, g_projection_matrix);
+    g_shader_program.use();
     
     glClearColor(BG_RED, BG_BLUE, BG_GREEN, BG_OPACITY);
     
-    GLuint player_texture_id = Utility::load_texture("assets/DinoSprites.png");
+    Utility::pack_textures(PACKED_TEXTURES, sizeof(PACKED_TEXTURES) / sizeof(PACKED_TEXTURES[0]));
+    
+    g_player_texture = Utility::acquire_texture("assets/DinoSprites.png");
+    GLuint player_texture_id = g_player_texture.id;
 
     int player_walking_animation[4][4] = {
         { 5, 6, 7, 8 }, // LEFT
@@ -150,12 +199,32 @@ void initialise()
         0.8f,                       // height
         PLAYER
     );
+    g_player->set_atlas_region(g_player_texture.region);
     
     
+    // ————— AUDIO ————— //
+    // Opened once here, with every clip decoded up front; scenes only borrow them
+    if (AudioSystem::open(AUDIO_FREQUENCY, AUDIO_CHANNELS, g_audio_buffer_size))
+    {
+        std::cout << "Audio buffer: " << AudioSystem::get_buffer_size() << " frames ("
+                  << AudioSystem::get_buffer_latency_ms() << " ms)" << std::endl;
+    }
+    
+    // ————— JOBS ————— //
+    JobSystem::start(g_job_workers);
+    std::cout << "Job workers: " << JobSystem::get_worker_count() << std::endl;
+    
+    // ————— INPUT ————— //
+    g_input.bind(BUTTON_LEFT,  SDL_SCANCODE_LEFT);
+    g_input.bind(BUTTON_RIGHT, SDL_SCANCODE_RIGHT);
+    g_input.bind(BUTTON_JUMP,  SDL_SCANCODE_SPACE);
+    g_input.bind(BUTTON_START, SDL_SCANCODE_RETURN);
+    g_input.bind(BUTTON_QUIT,  SDL_SCANCODE_Q);
+    g_input.bind(BUTTON_PROFILER, SDL_SCANCODE_F3);
+    
     // ————— Start SETUP ————— //
-    g_start = new Start();
-    switch_to_scene(g_start);
-    g_start->set_player(g_player);
+    g_scene_manager = new SceneManager(g_player);
+    switch_to_scene(START_SCENE);
 
 
 
@@ -165,159 +234,313 @@ void initialise()
 }
 
 void process_input()
+{
+    PROFILE_SCOPE("input");
+    
+    // The keys themselves are read a step at a time, in apply_input()
+    g_input.poll();
+    
+    if (g_input.get_is_quitting()) g_app_status = TERMINATED;
+}
+
+void apply_input(const InputSnapshot &input)
 {
     g_current_scene->get_state().player->set_movement(glm::vec3(0.0f));
     
-    SDL_Event event;
-    while (SDL_PollEvent(&event))
+    // ————— KEYSTROKES ————— //
+    if (input.was_pressed(BUTTON_QUIT))
     {
-        // ————— KEYSTROKES ————— //
-        switch (event.type) {
-            // ————— END GAME ————— //
-            case SDL_QUIT:
-            case SDL_WINDOWEVENT_CLOSE:
-                g_app_status = TERMINATED;
-                break;
-                
-            case SDL_KEYDOWN:
-                switch (event.key.keysym.sym) {
-                    case SDLK_q:
-                        // Quit the game with a keystroke
-                        g_app_status = TERMINATED;
-                        break;
-                        
-                    case SDLK_SPACE:
-                        // ————— JUMPING ————— //
-                        if (g_current_scene->get_state().player->get_collided_bottom())
-                        {
-                            g_current_scene->get_state().player->jump();
-                            Mix_PlayChannel(-1,  g_current_scene->get_state().jump_sfx, 0);
-                        }
-                         break;
-                        
-                    default:
-                        break;
-                    
-                    case SDLK_RETURN:
-                        if (game_started == false){
-                            g_level_a = new LevelA();
-                            switch_to_scene(g_level_a);
-                            game_started = true;
-                            g_level_a->set_player(g_player);
-                        }
-
-                    
-                }
-                
-            default:
-                break;
+        // Quit the game with a keystroke
+        g_app_status = TERMINATED;
+    }
+    
+    if (input.was_pressed(BUTTON_PROFILER)) g_is_profiler_shown = !g_is_profiler_shown;
+    
+    if (input.was_pressed(BUTTON_JUMP))
+    {
+        // ————— JUMPING ————— //
+        if (g_current_scene->get_state().player->get_collided_bottom())
+        {
+            g_current_scene->get_state().player->jump();
+            AudioSystem::play_sound(g_current_scene->get_state().jump_sfx);
+        }
+    }
+    
+    if (input.was_pressed(BUTTON_START))
+    {
+        if (game_started == false){
+            switch_to_scene(LEVEL_A_SCENE);
+            game_started = true;
+        }
+        else if (g_scene_manager->get_current_scene_id() == WIN_SCENE ||
+                 g_scene_manager->get_current_scene_id() == LOSE_SCENE)
+        {
+            // Back to the first level for another round
+            g_player->set_lives(PLAYER_START_LIVES);
+            g_player->set_velocity(glm::vec3(0.0f));
+            switch_to_scene(LEVEL_A_SCENE);
         }
     }
     
     // ————— KEY HOLD ————— //
-    const Uint8 *key_state = SDL_GetKeyboardState(NULL);
-
-    if (key_state[SDL_SCANCODE_LEFT])        g_current_scene->get_state().player->move_left();
-    else if (key_state[SDL_SCANCODE_RIGHT])  g_current_scene->get_state().player->move_right();
+    if (input.is_held(BUTTON_LEFT))        g_current_scene->get_state().player->move_left();
+    else if (input.is_held(BUTTON_RIGHT))  g_current_scene->get_state().player->move_right();
      
     if (glm::length( g_current_scene->get_state().player->get_movement()) > 1.0f)
         g_current_scene->get_state().player->normalise_movement();
- 
 }
 
 void update()
 {
-    // ————— DELTA TIME / FIXED TIME STEP CALCULATION ————— //
-    float ticks = (float)SDL_GetTicks() / MILLISECONDS_IN_SECOND;
-    float delta_time = ticks - g_previous_ticks;
-    g_previous_ticks = ticks;
+    PROFILE_SCOPE("update");
     
-    delta_time += g_accumulator;
+    // ————— DELTA TIME / FIXED TIME STEP CALCULATION ————— //
+    StepClockStats before = g_step_clock.get_stats();
+    Uint32         steps  = g_step_clock.advance(SDL_GetTicks());
+    StepClockStats after  = g_step_clock.get_stats();
     
-    if (delta_time < FIXED_TIMESTEP)
+    // Only the first time: under sustained load this would be every frame, and shutdown()
+    // prints the totals anyway
+    if (after.clamped_frames > before.clamped_frames && before.clamped_frames == 0)
     {
-        g_accumulator = delta_time;
-        return;
+        std::cout << "Simulation fell behind: ran " << steps << " steps, dropped "
+                  << after.dropped_steps - before.dropped_steps << "; totals at exit" << std::endl;
     }
     
-    while (delta_time >= FIXED_TIMESTEP) {
+    for (Uint32 step = 0; step < steps; step++) {
+        // ————— INPUT ————— //
+        InputSnapshot input = g_input.next_step();
+        
+        // A replay is over once its log runs out
+        if (g_input.get_is_finished())
+        {
+            g_app_status = TERMINATED;
+            break;
+        }
+        
+        apply_input(input);
+        
         // ————— UPDATING THE SCENE (i.e. map, character, enemies...) ————— //
-        g_current_scene->update(FIXED_TIMESTEP);
+        {
+            PROFILE_SCOPE("scene update");
+            g_current_scene->update(g_fixed_timestep);
+        }
         
-        if (g_current_scene == g_level_a && g_current_scene->get_state().player->get_position().x > 14.0f) {
-            g_level_b = new LevelB();
-            switch_to_scene(g_level_b);
-            g_level_b->set_player(g_player);
-            Mix_PlayChannel(-1,  g_current_scene->get_state().win_sfx, 0);
+        SceneId scene_id = g_scene_manager->get_current_scene_id();
+        
+        if (scene_id == LEVEL_A_SCENE && g_current_scene->get_state().player->get_position().x > 14.0f) {
+            switch_to_scene(LEVEL_B_SCENE);
+            AudioSystem::play_sound(g_current_scene->get_state().win_sfx);
 
 
         }
         
-        if (g_current_scene == g_level_b && g_current_scene->get_state().player->get_position().x > 14.0f) {
-            g_level_c = new LevelC();
-            switch_to_scene(g_level_c);
-            g_level_c->set_player(g_player);
-            Mix_PlayChannel(-1,  g_current_scene->get_state().win_sfx, 0);
+        if (scene_id == LEVEL_B_SCENE && g_current_scene->get_state().player->get_position().x > 14.0f) {
+            switch_to_scene(LEVEL_C_SCENE);
+            AudioSystem::play_sound(g_current_scene->get_state().win_sfx);
 
 
         }
-        if (g_current_scene == g_level_c && g_current_scene->get_state().player->get_position().x > 14.0f) {
-            g_win = new Win();
-            switch_to_scene(g_win);
-            Mix_PlayChannel(-1,  g_current_scene->get_state().win_sfx, 0);
+        if (scene_id == LEVEL_C_SCENE && g_current_scene->get_state().player->get_position().x > 14.0f) {
+            switch_to_scene(WIN_SCENE);
+            AudioSystem::play_sound(g_current_scene->get_state().win_sfx);
         }
         
         if (g_current_scene->get_state().player->get_lives() == 0) {
-            g_lose = new Lose();
-            switch_to_scene(g_lose);
+            switch_to_scene(LOSE_SCENE);
         }
-        
-        delta_time -= FIXED_TIMESTEP;
     }
     
-    g_accumulator = delta_time;
-    
     
     // ————— PLAYER CAMERA ————— //
+    // Follows the player where it's drawn this frame, between the last two steps
+    glm::vec3 player_position = g_current_scene->get_state().player->get_position(g_step_clock.get_alpha());
     g_view_matrix = glm::mat4(1.0f);
     
-    if (g_current_scene->get_state().player->get_position().x > LEVEL1_LEFT_EDGE) {
-        g_view_matrix = glm::translate(g_view_matrix, glm::vec3(-g_current_scene->get_state().player->get_position().x, 3.75, 0));
+    if (player_position.x > LEVEL1_LEFT_EDGE) {
+        g_view_matrix = glm::translate(g_view_matrix, glm::vec3(-player_position.x, 3.75, 0));
     } else {
         g_view_matrix = glm::translate(g_view_matrix, glm::vec3(-5, 3.75, 0));
     }
+    
+    // ————— MAP CULLING ————— //
+    // Un-project the corners of clip space to find the world rectangle on screen
+    glm::mat4 inverse_view_projection = glm::inverse(g_projection_matrix * g_view_matrix);
+    glm::vec4 view_bottom_left = inverse_view_projection * glm::vec4(-1.0f, -1.0f, 0.0f, 1.0f);
+    glm::vec4 view_top_right   = inverse_view_projection * glm::vec4( 1.0f,  1.0f, 0.0f, 1.0f);
+    
+    g_current_scene->get_state().map->set_view_bounds(view_bottom_left.x, view_top_right.x, view_top_right.y, view_bottom_left.y);
 }
 
 void render()
 {
-    g_shader_program.set_view_matrix(g_view_matrix);
+    {
+        PROFILE_SCOPE("render");
+        PROFILE_GPU_SCOPE("render");
+        
+        g_shader_program.set_view_matrix(g_view_matrix);
+        
+        glClear(GL_COLOR_BUFFER_BIT);
+        
+        // ————— RENDERING THE SCENE (i.e. map, character, enemies...) ————— //
+        g_current_scene->render(&g_shader_program, g_step_clock.get_alpha());
+        
+        render_profiler();
+    }
+    
+    PROFILE_SCOPE("swap");
+    SDL_GL_SwapWindow(g_display_window);
+}
+
+void render_profiler()
+{
+    if (!g_is_profiler_shown) return;
     
-    glClear(GL_COLOR_BUFFER_BIT);
+    if (g_profiler_lines.empty())
+    {
+        for (int i = 0; i < PROFILER_LINE_COUNT; i++)
+        {
+            glm::vec3 position = glm::vec3(-4.8f, 3.5f - i * PROFILER_LINE_HEIGHT, 0.0f);
+            g_profiler_lines.push_back(new Text(FONT_FILEPATH, "", PROFILER_FONT_SIZE, 0.0f, position));
+        }
+    }
     
-    // ————— RENDERING THE SCENE (i.e. map, character, enemies...) ————— //
-    g_current_scene->render(&g_shader_program);
+    // Text only rebuilds its buffer when the string changes, so most frames this is free
+    if (Profiler::get_frame() % PROFILER_REFRESH_FRAMES == 0)
+    {
+        for (int i = 0; i < PROFILER_LINE_COUNT; i++)
+        {
+            std::string line;
+            
+            if (i < Profiler::get_name_count())
+            {
+                bool        is_gpu;
+                const char *name = Profiler::get_name(i, &is_gpu);
+                
+                char buffer[64];
+                snprintf(buffer, sizeof(buffer), "%-12s %s %6.2f ms", name, is_gpu ? "gpu" : "cpu",
+                         Profiler::get_average_ms(name, is_gpu));
+                line = buffer;
+            }
+            
+            g_profiler_lines[i]->set_text(line);
+        }
+    }
     
-    SDL_GL_SwapWindow(g_display_window);
+    // Pinned to the screen rather than the world
+    g_shader_program.set_view_matrix(glm::mat4(1.0f));
+    for (Text *line : g_profiler_lines) line->render(&g_shader_program);
 }
 
 void shutdown()
 {    
+    g_input.close();
+    
+    StepClockStats stats = g_step_clock.get_stats();
+    std::cout << "Simulation: " << stats.steps << " steps over " << stats.frames << " frames, "
+              << stats.clamped_frames << " frames over " << g_step_clock.get_max_steps_per_frame()
+              << " steps, " << stats.dropped_steps << " steps dropped" << std::endl;
+    
+    ShaderProgramStats shader_stats = ShaderProgram::get_stats();
+    std::cout << "Shader state: " << shader_stats.issued << " GL calls, " << shader_stats.skipped
+              << " skipped as redundant" << std::endl;
+    
+    TextureCacheStats texture_stats = Utility::get_texture_cache_stats();
+    std::cout << "Textures: " << texture_stats.precompiled_loads << " images read from a .texcache, "
+              << texture_stats.decoded_loads << " decoded" << std::endl;
+    
+    if (g_profile_csv_path   != nullptr) Profiler::write_csv(g_profile_csv_path);
+    if (g_profile_trace_path != nullptr) Profiler::write_chrome_trace(g_profile_trace_path);
+    
+    // ————— DELETING SCENE DATA (i.e. map, character, enemies...) ————— //
+    delete g_scene_manager;
+    delete g_player;
+    
+    for (Text *line : g_profiler_lines) delete line;
+    Profiler::shutdown_gpu();
+    
+    JobSystem::stop();
+    
+    Utility::release_texture(g_player_texture);
+    Utility::unpack_textures();
+    AudioSystem::close();
     SDL_Quit();
+}
+
+// SDL's audio buffer holds at most 65535 sample frames, and wants a power of two
+int parse_audio_buffer_size(const char *argument)
+{
+    char *end;
+    long  frames = strtol(argument, &end, 10);
+    
+    if (end == argument || *end != '\0' || frames <= 0 || frames > 32768 || (frames & (frames - 1)) != 0)
+    {
+        LOG("--audio-buffer wants a power of two from 1 to 32768, not " << argument << "; using " << AUDIO_BUFFER_SIZE);
+        return AUDIO_BUFFER_SIZE;
+    }
     
-    // ————— DELETING LEVEL A DATA (i.e. map, character, enemies...) ————— //
-    delete g_level_a;
+    return (int) frames;
 }
 
 // ————— GAME LOOP ————— //
 int main(int argc, char* argv[])
 {
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "--audio-buffer") == 0) g_audio_buffer_size = parse_audio_buffer_size(argv[++i]);
+        
+        // Threads besides this one for the enemy update, by default one per remaining
+        // core; 0 keeps it all on this thread
+        else if (strcmp(argv[i], "--jobs") == 0) g_job_workers = atoi(argv[++i]);
+        
+        else if (strcmp(argv[i], "--max-steps-per-frame") == 0) g_step_clock.set_max_steps_per_frame(atoi(argv[++i]));
+        
+        // Rendering interpolates between steps, so big scenes can step less often (say
+        // 30 a second) and still move smoothly; input logs only replay at the rate they
+        // were recorded at
+        else if (strcmp(argv[i], "--steps-per-second") == 0 && atoi(argv[i + 1]) > 0)
+        {
+            g_step_clock.set_steps_per_second(atoi(argv[++i]));
+            g_fixed_timestep = g_step_clock.get_step_seconds();
+        }
+        
+        // Every fixed step's keys, to a log or back out of one
+        else if (strcmp(argv[i], "--record") == 0 && !g_input.record(argv[++i])) return 1;
+        else if (strcmp(argv[i], "--replay") == 0 && !g_input.replay(argv[++i])) return 1;
+        
+        // The last RING_SIZE profiler samples, written on the way out: a CSV, and a trace
+        // that chrome://tracing or Perfetto will open
+        else if (strcmp(argv[i], "--profile-csv")   == 0) g_profile_csv_path   = argv[++i];
+        else if (strcmp(argv[i], "--profile-trace") == 0) g_profile_trace_path = argv[++i];
+    }
+    
+    // Fixed-point physics, for runs that have to match another build bit for bit
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--deterministic") == 0) Simulation::set_deterministic(true);
+        
+        // The overlay from the start; F3 shows and hides it
+        if (strcmp(argv[i], "--profile") == 0) g_is_profiler_shown = true;
+        
+        // Enemies through SpriteBatch even where instancing works, to compare the two
+        if (strcmp(argv[i], "--no-instancing") == 0) InstanceBatch::set_is_enabled(false);
+    }
+    
+    // Most of it is getting the textures ready, which a .texcache next to each image cuts
+    // down to a mapping and an upload (see TextureFile and tools/texture_converter.cpp)
+    Uint32 start_ticks = SDL_GetTicks();
     initialise();
+    std::cout << "Started in " << SDL_GetTicks() - start_ticks << " ms" << std::endl;
     
     while (g_app_status == RUNNING)
     {
+        Profiler::begin_frame();
+        
         process_input();
         update();
         render();
+        
+        Profiler::end_frame();
     }
     
     shutdown();
@@ -1,11 +1,9 @@
 attribute vec4 position;
 
 uniform mat4 modelMatrix;
-uniform mat4 viewMatrix;
-uniform mat4 projectionMatrix;
+uniform mat4 viewProjectionMatrix;
 
 void main()
 {
-	vec4 p = viewMatrix * modelMatrix  * position;
-	gl_Position = projectionMatrix * p;
+	gl_Position = viewProjectionMatrix * modelMatrix * position;
 }
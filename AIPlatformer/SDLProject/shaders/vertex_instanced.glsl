@@ -0,0 +1,23 @@
+attribute vec2 position;
+attribute vec2 instanceOffset;
+attribute vec2 instanceScale;
+attribute float instanceFrame;
+
+uniform mat4 viewProjectionMatrix;
+uniform vec2 frameGrid;
+uniform vec4 frameRegion;
+
+varying vec2 texCoordVar;
+
+void main()
+{
+    // Frames count along each row of the grid, top row first
+    float row    = floor((instanceFrame + 0.5) / frameGrid.x);
+    float column = instanceFrame - row * frameGrid.x;
+
+    vec2 frame = (vec2(column, row) + vec2(position.x + 0.5, 0.5 - position.y)) / frameGrid;
+
+    // ...then into the part of the texture the sheet was packed into
+    texCoordVar = frameRegion.xy + frame * frameRegion.zw;
+    gl_Position = viewProjectionMatrix * vec4(position * instanceScale + instanceOffset, 0.0, 1.0);
+}
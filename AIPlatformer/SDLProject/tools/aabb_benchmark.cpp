@@ -0,0 +1,133 @@
+/**
+    Micro-benchmark for AABBBatch: one box against 16, 256, 4k and 64k packed targets,
+    timed for the per-pair Entity::check_collision maths and for every batched path this
+    CPU supports. Each path's hit mask is also checked against the scalar answers.
+
+    Build from AIPlatformer/SDLProject:
+        c++ -O2 -std=c++14 -I. tools/aabb_benchmark.cpp AABBBatch.cpp -o aabb_benchmark
+*/
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+#include "AABBBatch.h"
+
+#define REPEAT_TARGETS 8000000 // targets tested per measurement, so every size does similar work
+
+static const int TARGET_COUNTS[] = { 16, 256, 4096, 65536 };
+
+struct Targets
+{
+    std::vector<float> centers_x, centers_y, widths, heights;
+};
+
+static float random_range(float low, float high)
+{
+    return low + (high - low) * (rand() / (float) RAND_MAX);
+}
+
+static Targets make_targets(int count)
+{
+    Targets targets;
+    
+    for (int i = 0; i < count; i++)
+    {
+        targets.centers_x.push_back(random_range(-50.0f, 50.0f));
+        targets.centers_y.push_back(random_range(-10.0f, 10.0f));
+        targets.widths.push_back(random_range(0.5f, 2.0f));
+        targets.heights.push_back(random_range(0.5f, 2.0f));
+    }
+    
+    return targets;
+}
+
+// What the game did before AABBBatch: Entity::check_collision, one pair at a time
+static int count_hits_per_pair(float x, float y, float width, float height, const Targets &targets,
+                               std::vector<uint64_t> &hit_mask)
+{
+    int count = (int) targets.centers_x.size(),
+        hits  = 0;
+    
+    hit_mask.assign((count + 63) / 64, 0);
+    
+    for (int i = 0; i < count; i++)
+    {
+        float x_distance = fabs(x - targets.centers_x[i]) - ((width  + targets.widths[i])  / 2.0f);
+        float y_distance = fabs(y - targets.centers_y[i]) - ((height + targets.heights[i]) / 2.0f);
+        
+        if (x_distance < 0.0f && y_distance < 0.0f)
+        {
+            hit_mask[i >> 6] |= (uint64_t) 1 << (i & 63);
+            hits++;
+        }
+    }
+    
+    return hits;
+}
+
+template <typename Test>
+static double nanoseconds_per_target(int count, Test test)
+{
+    int repeats = REPEAT_TARGETS / count;
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int repeat = 0; repeat < repeats; repeat++) test(repeat);
+    auto end   = std::chrono::high_resolution_clock::now();
+    
+    return std::chrono::duration<double, std::nano>(end - start).count() / ((double) repeats * count);
+}
+
+int main()
+{
+    srand(1);
+    
+    AABBBatch::Path best = AABBBatch::get_path();
+    
+    std::cout << "best path: " << AABBBatch::get_path_name(best) << "\n\n";
+    std::cout << std::setw(8) << "targets" << std::setw(12) << "per-pair";
+    for (int path = AABBBatch::SCALAR; path <= best; path++)
+        std::cout << std::setw(12) << AABBBatch::get_path_name((AABBBatch::Path) path);
+    std::cout << "   (ns per target)\n";
+    
+    bool all_match = true;
+    
+    for (int count : TARGET_COUNTS)
+    {
+        Targets targets = make_targets(count);
+        std::vector<uint64_t> expected, hit_mask;
+        volatile int sink = 0;
+        
+        std::cout << std::setw(8) << count << std::fixed << std::setprecision(3);
+        
+        // Nudge the box every repeat so nothing gets hoisted out of the loop
+        std::cout << std::setw(12) << nanoseconds_per_target(count, [&](int repeat)
+        {
+            sink += count_hits_per_pair(repeat * 0.001f, 0.0f, 1.0f, 1.0f, targets, expected);
+        });
+        
+        count_hits_per_pair(0.0f, 0.0f, 1.0f, 1.0f, targets, expected);
+        
+        for (int path = AABBBatch::SCALAR; path <= best; path++)
+        {
+            AABBBatch::set_path((AABBBatch::Path) path);
+            
+            std::cout << std::setw(12) << nanoseconds_per_target(count, [&](int repeat)
+            {
+                sink += AABBBatch::overlap(repeat * 0.001f, 0.0f, 1.0f, 1.0f, targets.centers_x.data(),
+                                           targets.centers_y.data(), targets.widths.data(), targets.heights.data(),
+                                           count, hit_mask);
+            });
+            
+            AABBBatch::overlap(0.0f, 0.0f, 1.0f, 1.0f, targets.centers_x.data(), targets.centers_y.data(),
+                               targets.widths.data(), targets.heights.data(), count, hit_mask);
+            if (hit_mask != expected) all_match = false;
+        }
+        
+        std::cout << "\n";
+    }
+    
+    std::cout << "\nhit masks " << (all_match ? "match" : "DO NOT match") << " the per-pair test\n";
+    return all_match ? 0 : 1;
+}
@@ -0,0 +1,381 @@
+/**
+    Headless simulation benchmark. Runs the game's scenes at FIXED_TIMESTEP from a
+    scripted input file, with no window, GL context or audio device, then prints
+    per-step timing percentiles and a hash of the final state. Two runs of the same
+    script on the same build must print the same hash.
+    
+    --record writes the keys every step saw to an input log (see Input.h), which main.cpp
+    can replay with --replay, and the other way round: "./headless --replay <log>" runs
+    a session recorded in the game instead of a script, as fast as it will go.
+    
+    With "fixed" the simulation runs in its deterministic mode (see Simulation.h), where
+    the hash must match across builds too. --trace writes Simulation::checksum() after
+    every step, one "<step> <hash>" line each; --compare checks every step against such
+    a trace and stops at the first one that differs, so a golden trace recorded before
+    an optimisation pins down exactly where it changed the simulation. --profile writes
+    a Chrome trace of the Profiler scopes (see Profiler.h), one frame per step.
+
+    Build from AIPlatformer/SDLProject, linking tools/null_gl.cpp instead of OpenGL:
+        c++ -O2 -std=c++14 -I. $(sdl2-config --cflags) tools/headless.cpp tools/null_gl.cpp \
+            $(ls *.cpp | grep -v main.cpp) $(sdl2-config --libs) -lSDL2_mixer -o headless
+    and run it from the same directory so the scenes find assets/:
+        ./headless <script | --replay <log>> [a|b|c] [sync] [fixed]
+                   [--jobs <n>] [--record <log>] [--trace <file>] [--compare <file>] [--profile <file>]
+    e.g.
+        ./headless tools/scripts/level_a_run.txt
+    "sync" turns off background preloading, to compare scene switch times. --jobs <n>
+    steps the enemies on n JobSystem workers; the hash must not change with n.
+
+    Script format, one command per line, in step order ('#' starts a comment):
+        <step> left | right | release    hold a direction from this step on
+        <step> jump                      jump on this step, if standing
+        <step> enter                     press ENTER (restarts from the Win/Lose screens)
+        <step> end                       stop after this many steps
+*/
+#define FIXED_TIMESTEP 0.0166666f
+#define DEFAULT_STEPS  3600
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Entity.h"
+#include "Scene.h"
+#include "SceneManager.h"
+#include "AudioSystem.h"
+#include "Simulation.h"
+#include "Input.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#define PLAYER_START_LIVES 3
+
+enum ScriptAction { HOLD_LEFT, HOLD_RIGHT, RELEASE, JUMP, ENTER, END };
+
+struct ScriptCommand
+{
+    int          step;
+    ScriptAction action;
+};
+
+// ————— GLOBAL VARIABLES ————— //
+Scene        *g_current_scene = nullptr;
+SceneManager *g_scene_manager = nullptr;
+Entity       *g_player        = nullptr;
+Input         g_input;
+
+int   g_scene_loads      = 0,
+      g_preloaded_loads  = 0;
+float g_worst_switch_ms  = 0.0f;
+
+void switch_to_scene(SceneId scene_id)
+{
+    g_scene_manager->switch_to(scene_id);
+    g_current_scene = g_scene_manager->get_current_scene();
+    
+    SceneLoadTiming timing = g_scene_manager->get_last_load_timing();
+    g_scene_loads++;
+    g_preloaded_loads += timing.was_preloaded;
+    g_worst_switch_ms  = std::max(g_worst_switch_ms, timing.switch_ms);
+}
+
+bool load_script(const char *filepath, std::vector<ScriptCommand> &commands, int *step_count)
+{
+    std::ifstream file(filepath);
+    if (!file)
+    {
+        std::cerr << "Unable to open script " << filepath << std::endl;
+        return false;
+    }
+    
+    std::string line;
+    int line_number = 0;
+    
+    while (std::getline(file, line))
+    {
+        line_number++;
+        line = line.substr(0, line.find('#'));
+        
+        std::istringstream words(line);
+        ScriptCommand command;
+        std::string action;
+        
+        if (!(words >> command.step)) continue;
+        words >> action;
+        
+        if      (action == "left")    command.action = HOLD_LEFT;
+        else if (action == "right")   command.action = HOLD_RIGHT;
+        else if (action == "release") command.action = RELEASE;
+        else if (action == "jump")    command.action = JUMP;
+        else if (action == "enter")   command.action = ENTER;
+        else if (action == "end")     command.action = END;
+        else
+        {
+            std::cerr << filepath << ":" << line_number << ": unknown action '" << action << "'" << std::endl;
+            return false;
+        }
+        
+        if (command.action == END) *step_count = command.step;
+        else commands.push_back(command);
+    }
+    
+    std::stable_sort(commands.begin(), commands.end(),
+                     [](const ScriptCommand &a, const ScriptCommand &b) { return a.step < b.step; });
+    return true;
+}
+
+// Same player as main.cpp's initialise()
+Entity *create_player()
+{
+    int player_walking_animation[4][4] = {
+        { 5, 6, 7, 8 }, // LEFT
+        { 5, 6, 7, 8 }, // RIGHT
+        { 0, 1, 2, 3 }, // UP
+        { 0, 1, 2, 3 }  // DOWN
+    };
+    
+    return new Entity(0, 2.5f, glm::vec3(0.0f, -4.81f, 0.0f), 5.0f, player_walking_animation, 0.0f,
+                      4, 0, 24, 1, 1.0f, 0.8f, PLAYER);
+}
+
+// The scene changes main.cpp's update() makes after every fixed step
+void advance_scenes()
+{
+    SceneId scene_id = g_scene_manager->get_current_scene_id();
+    float   player_x = g_current_scene->get_state().player->get_position().x;
+    
+    if      (scene_id == LEVEL_A_SCENE && player_x > 14.0f) switch_to_scene(LEVEL_B_SCENE);
+    else if (scene_id == LEVEL_B_SCENE && player_x > 14.0f) switch_to_scene(LEVEL_C_SCENE);
+    else if (scene_id == LEVEL_C_SCENE && player_x > 14.0f) switch_to_scene(WIN_SCENE);
+    
+    if (g_current_scene->get_state().player->get_lives() == 0) switch_to_scene(LOSE_SCENE);
+}
+
+// Mirrors main.cpp's apply_input(), but we start in a level so ENTER only restarts
+void apply_input(const InputSnapshot &input)
+{
+    Entity *player = g_current_scene->get_state().player;
+    player->set_movement(glm::vec3(0.0f));
+    
+    if (input.was_pressed(BUTTON_JUMP) && player->get_collided_bottom()) player->jump();
+    
+    SceneId scene_id = g_scene_manager->get_current_scene_id();
+    if (input.was_pressed(BUTTON_START) && (scene_id == WIN_SCENE || scene_id == LOSE_SCENE))
+    {
+        g_player->set_lives(PLAYER_START_LIVES);
+        g_player->set_velocity(glm::vec3(0.0f));
+        switch_to_scene(LEVEL_A_SCENE);
+    }
+    
+    player = g_current_scene->get_state().player;
+    
+    if      (input.is_held(BUTTON_LEFT))  player->move_left();
+    else if (input.is_held(BUTTON_RIGHT)) player->move_right();
+}
+
+// ————— STATE HASH ————— //
+uint64_t hash_state()
+{
+    GameState state = g_current_scene->get_state();
+    return Simulation::checksum(g_scene_manager->get_current_scene_id(), state.player, state.enemies);
+}
+
+// A trace written by --trace, as one hash per step
+bool load_trace(const char *filepath, std::vector<uint64_t> &hashes)
+{
+    std::ifstream file(filepath);
+    if (!file)
+    {
+        std::cerr << "Unable to open trace " << filepath << std::endl;
+        return false;
+    }
+    
+    int      step;
+    uint64_t hash;
+    while (file >> std::dec >> step >> std::hex >> hash) hashes.push_back(hash);
+    
+    return true;
+}
+
+double percentile(const std::vector<double> &sorted, double fraction)
+{
+    size_t rank = (size_t) std::ceil(fraction * sorted.size());
+    return sorted[std::max((size_t) 1, rank) - 1];
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <script | --replay <log>> [a|b|c] [sync] [fixed] [--jobs <n>] [--record <log>]"
+                  << " [--trace <file>] [--compare <file>] [--profile <file>]" << std::endl;
+        return 1;
+    }
+    
+    std::vector<ScriptCommand> commands;
+    int step_count   = DEFAULT_STEPS;
+    int first_option = 2;
+    
+    if (strcmp(argv[1], "--replay") == 0 && argc > 2)
+    {
+        if (!g_input.replay(argv[2])) return 1;
+        first_option = 3;
+    }
+    else if (!load_script(argv[1], commands, &step_count)) return 1;
+    
+    bool replaying = g_input.get_mode() == Input::REPLAYING;
+    
+    const char *level      = "a";
+    bool        preloading = true;
+    
+    std::ofstream         trace;
+    std::vector<uint64_t> golden;
+    bool                  comparing = false;
+    const char           *profile   = nullptr;
+    
+    for (int i = first_option; i < argc; i++)
+    {
+        if      (strcmp(argv[i], "sync")  == 0) preloading = false;
+        else if (strcmp(argv[i], "fixed") == 0) Simulation::set_deterministic(true);
+        else if (strcmp(argv[i], "--jobs")  == 0 && i + 1 < argc) JobSystem::start(atoi(argv[++i]));
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            if (replaying || !g_input.record(argv[++i])) return 1;
+        }
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+        {
+            trace.open(argv[++i]);
+            if (!trace)
+            {
+                std::cerr << "Unable to write trace " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc)
+        {
+            if (!load_trace(argv[++i], golden)) return 1;
+            comparing = true;
+        }
+        else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) profile = argv[++i];
+        else level = argv[i];
+    }
+    
+    // No device to play on, so the mixer gets SDL's silent driver
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    SDL_Init(SDL_INIT_AUDIO);
+    AudioSystem::open(44100, 2, 512);
+    
+    g_player        = create_player();
+    g_scene_manager = new SceneManager(g_player);
+    g_scene_manager->set_preloading(preloading);
+    
+    if      (strcmp(level, "b") == 0) switch_to_scene(LEVEL_B_SCENE);
+    else if (strcmp(level, "c") == 0) switch_to_scene(LEVEL_C_SCENE);
+    else                              switch_to_scene(LEVEL_A_SCENE);
+    
+    // ————— SIMULATION ————— //
+    std::vector<double> step_times;
+    step_times.reserve(step_count);
+    
+    size_t next_command = 0;
+    int    divergence   = -1;
+    
+    auto run_start = std::chrono::steady_clock::now();
+    
+    // A replay runs until its log does
+    for (int step = 0; replaying || step < step_count; step++)
+    {
+        Profiler::begin_frame();
+        
+        // The script stands in for the keyboard
+        for (; next_command < commands.size() && commands[next_command].step <= step; next_command++)
+        {
+            switch (commands[next_command].action)
+            {
+                case HOLD_LEFT:  g_input.set_held(BUTTON_LEFT, true);  g_input.set_held(BUTTON_RIGHT, false); break;
+                case HOLD_RIGHT: g_input.set_held(BUTTON_RIGHT, true); g_input.set_held(BUTTON_LEFT, false);  break;
+                case RELEASE:    g_input.set_held(BUTTON_LEFT, false); g_input.set_held(BUTTON_RIGHT, false); break;
+                case JUMP:       g_input.press(BUTTON_JUMP);  break;
+                case ENTER:      g_input.press(BUTTON_START); break;
+                default:         break;
+            }
+        }
+        
+        InputSnapshot input = g_input.next_step();
+        if (g_input.get_is_finished()) break;
+        
+        apply_input(input);
+        
+        auto start = std::chrono::steady_clock::now();
+        
+        g_current_scene->update(FIXED_TIMESTEP);
+        advance_scenes();
+        
+        auto end = std::chrono::steady_clock::now();
+        step_times.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        
+        Profiler::end_frame();
+        
+        if (!trace.is_open() && !comparing) continue;
+        
+        uint64_t hash = hash_state();
+        if (trace.is_open()) trace << std::dec << step << " " << std::hex << std::setw(16) << std::setfill('0') << hash << "\n";
+        
+        if (comparing && (step >= (int) golden.size() || golden[step] != hash))
+        {
+            divergence = step;
+            break;
+        }
+    }
+    
+    double run_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start).count();
+    
+    uint64_t final_hash = hash_state();
+    g_input.close();
+    
+    if (profile != nullptr) Profiler::write_chrome_trace(profile);
+    JobSystem::stop();
+    
+    // ————— REPORT ————— //
+    std::vector<double> sorted = step_times;
+    std::sort(sorted.begin(), sorted.end());
+    
+    std::cout << std::fixed << std::setprecision(2);
+    const char *scene_names[] = { "Start", "LevelA", "LevelB", "LevelC", "Win", "Lose" };
+    
+    std::cout << "steps:      " << step_times.size() << "\n";
+    std::cout << "scene:      " << scene_names[g_scene_manager->get_current_scene_id()]
+              << " (" << g_current_scene->get_state().player->get_lives() << " lives)\n";
+    if (!sorted.empty())
+    {
+        std::cout << "p50 (us):   " << percentile(sorted, 0.50) << "\n";
+        std::cout << "p99 (us):   " << percentile(sorted, 0.99) << "\n";
+        std::cout << "max (us):   " << sorted.back() << "\n";
+    }
+    if (run_seconds > 0)
+        std::cout << "speed:      " << step_times.size() * FIXED_TIMESTEP / run_seconds << "x real time\n";
+    std::cout << "scene loads: " << g_scene_loads << " (" << g_preloaded_loads << " preloaded), worst switch "
+              << g_worst_switch_ms << " ms\n";
+    std::cout << "mode:       " << (Simulation::get_is_deterministic() ? "fixed-point" : "float") << "\n";
+    if (comparing)
+    {
+        if (divergence < 0) std::cout << "trace:      matches all " << step_times.size() << " steps\n";
+        else                std::cout << "trace:      diverges at step " << divergence << "\n";
+    }
+    std::cout << "state hash: " << std::hex << std::setw(16) << std::setfill('0') << final_hash << std::endl;
+    
+    delete g_scene_manager;
+    delete g_player;
+    
+    AudioSystem::close();
+    SDL_Quit();
+    return divergence < 0 ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+/**
+    Benchmark for the parallel enemy update: steps an EntityStore of 50k and 200k enemies
+    (walkers, guards and patrols in equal shares) over a wide map with a floor and some
+    pillars, first on the calling thread alone and then with 1, 2, 4 ... JobSystem
+    workers up to one per core. Each run's final positions are hashed and checked
+    against the single-threaded run's, since the split must not change the result.
+
+    Build from AIPlatformer/SDLProject, linking tools/null_gl.cpp instead of OpenGL:
+        c++ -O2 -std=c++14 -pthread -I. $(sdl2-config --cflags) tools/job_benchmark.cpp tools/null_gl.cpp \
+            JobSystem.cpp EntityStore.cpp Entity.cpp Map.cpp LevelFile.cpp Simulation.cpp SpatialHash.cpp \
+            AABBBatch.cpp SpriteBatch.cpp InstanceBatch.cpp ShaderProgram.cpp Profiler.cpp $(sdl2-config --libs) -o job_benchmark
+    Usage:
+        ./job_benchmark [steps]
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "JobSystem.h"
+#include "EntityStore.h"
+#include "Map.h"
+
+#define MAP_WIDTH     4096
+#define MAP_HEIGHT    16
+#define DEFAULT_STEPS 120
+#define FIXED_TIMESTEP 0.0166666f
+
+static const int ENEMY_COUNTS[] = { 50000, 200000 };
+
+static void fill_map(std::vector<uint16_t> &tiles)
+{
+    tiles.assign(MAP_WIDTH * MAP_HEIGHT, 0);
+
+    for (int x = 0; x < MAP_WIDTH; x++)
+    {
+        tiles[(MAP_HEIGHT - 1) * MAP_WIDTH + x] = 1;
+
+        // A two-high pillar every 16 tiles for the walkers to run into
+        if (x % 16 == 8)
+        {
+            tiles[(MAP_HEIGHT - 2) * MAP_WIDTH + x] = 1;
+            tiles[(MAP_HEIGHT - 3) * MAP_WIDTH + x] = 1;
+        }
+    }
+}
+
+static void spawn(EntityStore &store, int count, Map *map)
+{
+    static const AIType  TYPES[]  = { WALKER, GUARD, PATROL };
+    static const AIState STATES[] = { WALKING, IDLE, WALKING };
+
+    store.reserve(count);
+
+    for (int i = 0; i < count; i++)
+    {
+        int enemy = store.add(Entity(0, 1.0f, 1.0f, 1.0f, ENEMY, TYPES[i % 3], STATES[i % 3]));
+
+        float x = map->get_left_bound() + 1.0f + (i * 7919 % (MAP_WIDTH - 2)),
+              y = map->get_top_bound() - 2.0f - (i % 5);
+
+        store.set_position(enemy, glm::vec3(x, y, 0.0f));
+        store.set_acceleration(enemy, glm::vec3(0.0f, -9.81f, 0.0f));
+    }
+}
+
+static uint64_t hash_positions(const EntityStore &store)
+{
+    uint64_t hash = 14695981039346656037ull;
+
+    const float *arrays[] = { store.get_positions_x(), store.get_positions_y() };
+    for (const float *positions : arrays)
+    {
+        const unsigned char *bytes = (const unsigned char *) positions;
+
+        for (size_t i = 0; i < store.get_count() * sizeof(float); i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    }
+
+    return hash;
+}
+
+// Steps a fresh store; returns nanoseconds per step and leaves the final hash in *hash
+static double run(int enemy_count, int steps, Map *map, Entity *player, uint64_t *hash)
+{
+    EntityStore store;
+    spawn(store, enemy_count, map);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int step = 0; step < steps; step++) store.update(FIXED_TIMESTEP, player, map);
+
+    auto end = std::chrono::steady_clock::now();
+    *hash = hash_positions(store);
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / steps;
+}
+
+int main(int argc, char* argv[])
+{
+    int steps = argc > 1 ? atoi(argv[1]) : DEFAULT_STEPS;
+    if (steps <= 0) steps = DEFAULT_STEPS;
+
+    std::vector<uint16_t> tiles;
+    fill_map(tiles);
+    Map map(MAP_WIDTH, MAP_HEIGHT, tiles.data(), 0, 1.0f, 1, 1, false);
+
+    Entity player(0, 1.0f, 1.0f, 1.0f, PLAYER);
+    player.set_position(glm::vec3(MAP_WIDTH / 2.0f, map.get_top_bound() - 2.0f, 0.0f));
+
+    int core_count = std::max((int) std::thread::hardware_concurrency(), 1);
+    std::cout << core_count << " cores, " << steps << " steps per run" << std::endl;
+
+    std::vector<int> worker_counts = { 0 };
+    for (int workers = 1; workers < core_count; workers *= 2) worker_counts.push_back(workers);
+    if (worker_counts.back() != core_count - 1 && core_count > 1) worker_counts.push_back(core_count - 1);
+
+    bool all_match = true;
+
+    for (int enemy_count : ENEMY_COUNTS)
+    {
+        std::cout << "\n" << enemy_count << " enemies" << std::endl;
+
+        double   serial_ns   = 0.0;
+        uint64_t serial_hash = 0;
+
+        for (int workers : worker_counts)
+        {
+            JobSystem::start(workers);
+
+            JobStats before = JobSystem::get_stats();
+            uint64_t hash;
+            double   step_ns = run(enemy_count, steps, &map, &player, &hash);
+            JobStats after   = JobSystem::get_stats();
+
+            JobSystem::stop();
+
+            if (workers == 0)
+            {
+                serial_ns   = step_ns;
+                serial_hash = hash;
+            }
+
+            bool match = hash == serial_hash;
+            all_match  = all_match && match;
+
+            std::cout << "  " << std::setw(2) << workers + 1 << " threads: "
+                      << std::fixed << std::setprecision(3) << step_ns / 1e6 << " ms/step, "
+                      << std::setprecision(2) << serial_ns / step_ns << "x, "
+                      << after.steals - before.steals << " ranges stolen"
+                      << (match ? "" : "  MISMATCH") << std::endl;
+        }
+    }
+
+    return all_match ? 0 : 1;
+}
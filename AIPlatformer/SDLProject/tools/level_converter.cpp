@@ -0,0 +1,219 @@
+/**
+    Converts a level written as a C array of tile ids, like the LEVELA_DATA[] arrays the
+    scenes used to compile in, into a .lvl file that LevelFile can map (see LevelFile.h).
+
+    Build from AIPlatformer/SDLProject:
+        c++ -O2 -std=c++14 -I. tools/level_converter.cpp LevelFile.cpp -o level_converter
+
+    Usage:
+        ./level_converter <source> <ARRAY_NAME> <width> <height> <output.lvl> [options]
+    Options:
+        --tileset <path>               tileset image (default assets/tilemap_packed.png)
+        --tileset-size <cols>x<rows>   tiles across and down the tileset (default 20x12)
+        --tile-size <size>             world units per tile (default 1.0)
+        --chunked                      store the tiles in LEVEL_FILE_CHUNK_SIZE blocks, so
+                                       the map can stream them (see Map's streaming mode)
+        --enemy <x>,<y>,<ai type>,<ai state>
+                                       an enemy spawn; ai type is walker, guard or patrol
+                                       and ai state is walking, idle or attacking. Repeat
+                                       for more enemies.
+    Example:
+        ./level_converter LevelA.cpp LEVELA_DATA 14 8 assets/levels/level_a.lvl \
+            --enemy 10,2,walker,walking
+*/
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "LevelFile.h"
+
+// In the order of Entity.h's AIType and AIState
+static const char *const AI_TYPE_NAMES[]  = { "walker", "guard", "patrol" },
+                  *const AI_STATE_NAMES[] = { "walking", "idle", "attacking" };
+
+static int find_name(const std::string &name, const char *const *names, int count)
+{
+    for (int i = 0; i < count; i++)
+        if (name == names[i]) return i;
+
+    return -1;
+}
+
+// Pulls the numbers out of "<array_name>[] = { ... };" in a source file
+static bool read_array(const char *filepath, const char *array_name, std::vector<uint16_t> &tiles)
+{
+    std::ifstream file(filepath);
+    if (!file)
+    {
+        std::cerr << "Unable to open " << filepath << std::endl;
+        return false;
+    }
+
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string source = contents.str();
+
+    size_t name = source.find(std::string(array_name) + "[]");
+    size_t open = name == std::string::npos ? name : source.find('{', name);
+    size_t close = open == std::string::npos ? open : source.find('}', open);
+
+    if (close == std::string::npos)
+    {
+        std::cerr << "No array " << array_name << "[] = { ... } in " << filepath << std::endl;
+        return false;
+    }
+
+    const char *cursor = source.c_str() + open + 1,
+               *end    = source.c_str() + close;
+
+    while (cursor < end)
+    {
+        if (!isdigit((unsigned char) *cursor))
+        {
+            cursor++;
+            continue;
+        }
+
+        char *after;
+        unsigned long tile = strtoul(cursor, &after, 0);
+
+        if (tile > UINT16_MAX)
+        {
+            std::cerr << "Tile id " << tile << " does not fit in 16 bits" << std::endl;
+            return false;
+        }
+
+        tiles.push_back((uint16_t) tile);
+        cursor = after;
+    }
+
+    return true;
+}
+
+// Row-major tiles into the block layout LevelFile.h describes
+static std::vector<uint16_t> to_chunks(const std::vector<uint16_t> &tiles, int width, int height, int chunk_size)
+{
+    std::vector<uint16_t> chunked(LevelFile::get_stored_tile_count(width, height, chunk_size), 0);
+    int chunk_count_x = (width + chunk_size - 1) / chunk_size;
+
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            size_t chunk = (size_t) (y / chunk_size) * chunk_count_x + x / chunk_size;
+            chunked[chunk * chunk_size * chunk_size + (y % chunk_size) * chunk_size + x % chunk_size] = tiles[(size_t) y * width + x];
+        }
+    }
+
+    return chunked;
+}
+
+static bool parse_enemy(const char *text, LevelEnemySpawn &spawn)
+{
+    std::stringstream fields(text);
+    std::string x, y, ai_type, ai_state;
+
+    if (!std::getline(fields, x, ',') || !std::getline(fields, y, ',') ||
+        !std::getline(fields, ai_type, ',') || !std::getline(fields, ai_state)) return false;
+
+    int type  = find_name(ai_type,  AI_TYPE_NAMES,  3),
+        state = find_name(ai_state, AI_STATE_NAMES, 3);
+    if (type < 0 || state < 0) return false;
+
+    spawn.x        = (float) atof(x.c_str());
+    spawn.y        = (float) atof(y.c_str());
+    spawn.ai_type  = (uint32_t) type;
+    spawn.ai_state = (uint32_t) state;
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 6)
+    {
+        std::cerr << "usage: " << argv[0] << " <source> <ARRAY_NAME> <width> <height> <output.lvl> [options]" << std::endl;
+        return 1;
+    }
+
+    LevelFileHeader header = {};
+    header.width        = (uint32_t) atoi(argv[3]);
+    header.height       = (uint32_t) atoi(argv[4]);
+    header.tile_size    = 1.0f;
+    header.tile_count_x = 20;
+    header.tile_count_y = 12;
+
+    std::string tileset = "assets/tilemap_packed.png";
+    std::vector<LevelEnemySpawn> enemies;
+
+    for (int i = 6; i < argc; i++)
+    {
+        bool has_value = i + 1 < argc;
+
+        if (strcmp(argv[i], "--tileset") == 0 && has_value)
+        {
+            tileset = argv[++i];
+        }
+        else if (strcmp(argv[i], "--tileset-size") == 0 && has_value &&
+                 sscanf(argv[i + 1], "%ux%u", &header.tile_count_x, &header.tile_count_y) == 2)
+        {
+            i++;
+        }
+        else if (strcmp(argv[i], "--tile-size") == 0 && has_value)
+        {
+            header.tile_size = (float) atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--chunked") == 0)
+        {
+            header.chunk_size = LEVEL_FILE_CHUNK_SIZE;
+        }
+        else if (strcmp(argv[i], "--enemy") == 0 && has_value)
+        {
+            LevelEnemySpawn spawn;
+            if (!parse_enemy(argv[++i], spawn))
+            {
+                std::cerr << "Bad enemy '" << argv[i] << "', expected <x>,<y>,<ai type>,<ai state>" << std::endl;
+                return 1;
+            }
+            enemies.push_back(spawn);
+        }
+        else
+        {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    if (tileset.size() >= LEVEL_TILESET_PATH_SIZE)
+    {
+        std::cerr << "Tileset path is longer than " << LEVEL_TILESET_PATH_SIZE - 1 << " characters" << std::endl;
+        return 1;
+    }
+    strcpy(header.tileset_path, tileset.c_str());
+
+    std::vector<uint16_t> tiles;
+    if (!read_array(argv[1], argv[2], tiles)) return 1;
+
+    if (tiles.size() != (size_t) header.width * header.height)
+    {
+        std::cerr << argv[2] << " has " << tiles.size() << " tiles, expected " << header.width << " x " << header.height << std::endl;
+        return 1;
+    }
+
+    header.enemy_count = (uint32_t) enemies.size();
+    if (header.chunk_size > 0) tiles = to_chunks(tiles, header.width, header.height, header.chunk_size);
+
+    if (!LevelFile::write(argv[5], header, tiles.data(), enemies.data()))
+    {
+        std::cerr << "Unable to write " << argv[5] << std::endl;
+        return 1;
+    }
+
+    std::cout << argv[5] << ": " << header.width << " x " << header.height << " tiles"
+              << (header.chunk_size > 0 ? " in chunks, " : ", ") << header.enemy_count << " enemies" << std::endl;
+    return 0;
+}
@@ -0,0 +1,75 @@
+/**
+    No-op OpenGL for the headless build. Linking this instead of the system GL library
+    lets the scenes create their maps, textures and text without a context. Buffer and
+    texture names are still handed out, because code like Map treats 0 as "nothing
+    allocated".
+
+    Only the entry points the game calls are here; add to it when the game starts
+    calling something new.
+*/
+#define GL_SILENCE_DEPRECATION
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+
+static GLuint g_next_name = 1;
+
+// What glUseProgram last bound, and what was bound at the last glDrawArrays, for tools
+// that check which program draws what (see tools/render_state_test.cpp)
+GLuint g_null_gl_bound_program = 0,
+       g_null_gl_draw_program  = 0;
+
+static void generate_names(GLsizei count, GLuint *names)
+{
+    for (GLsizei i = 0; i < count; i++) names[i] = g_next_name++;
+}
+
+// ————— TEXTURES ————— //
+void glGenTextures(GLsizei n, GLuint *textures) { generate_names(n, textures); }
+void glDeleteTextures(GLsizei n, const GLuint *textures) { }
+void glBindTexture(GLenum target, GLuint texture) { }
+void glTexParameteri(GLenum target, GLenum pname, GLint param) { }
+void glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border,
+                  GLenum format, GLenum type, const void *pixels) { }
+
+// ————— BUFFERS ————— //
+void glGenBuffers(GLsizei n, GLuint *buffers) { generate_names(n, buffers); }
+void glDeleteBuffers(GLsizei n, const GLuint *buffers) { }
+void glBindBuffer(GLenum target, GLuint buffer) { }
+void glBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage) { }
+void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) { }
+
+// ————— DRAWING ————— //
+void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+                           const void *pointer) { }
+void glEnableVertexAttribArray(GLuint index) { }
+void glDisableVertexAttribArray(GLuint index) { }
+void glDrawArrays(GLenum mode, GLint first, GLsizei count) { g_null_gl_draw_program = g_null_gl_bound_program; }
+void glDrawElements(GLenum mode, GLsizei count, GLenum type, const void *indices) { }
+
+// ————— SHADERS ————— //
+GLuint glCreateProgram() { return g_next_name++; }
+GLuint glCreateShader(GLenum type) { return g_next_name++; }
+void glDeleteProgram(GLuint program) { }
+void glDeleteShader(GLuint shader) { }
+void glShaderSource(GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length) { }
+void glCompileShader(GLuint shader) { }
+void glAttachShader(GLuint program, GLuint shader) { }
+void glLinkProgram(GLuint program) { }
+void glUseProgram(GLuint program) { g_null_gl_bound_program = program; }
+void glGetShaderiv(GLuint shader, GLenum pname, GLint *params) { *params = GL_TRUE; }
+void glGetProgramiv(GLuint program, GLenum pname, GLint *params) { *params = GL_TRUE; }
+void glGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog)
+{
+    if (length != nullptr) *length = 0;
+    if (bufSize > 0) infoLog[0] = '\0';
+}
+GLint glGetAttribLocation(GLuint program, const GLchar *name) { return 0; }
+GLint glGetUniformLocation(GLuint program, const GLchar *name) { return 0; }
+void glUniform2f(GLint location, GLfloat v0, GLfloat v1) { }
+void glUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) { }
+void glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) { }
+void glGenQueries(GLsizei n, GLuint *ids) { for (GLsizei i = 0; i < n; i++) ids[i] = g_next_name++; }
+void glDeleteQueries(GLsizei n, const GLuint *ids) { }
+void glBeginQuery(GLenum target, GLuint id) { }
+void glEndQuery(GLenum target) { }
+void glGetQueryObjectiv(GLuint id, GLenum pname, GLint *params) { *params = 0; }
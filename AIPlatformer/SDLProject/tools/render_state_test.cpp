@@ -0,0 +1,100 @@
+/**
+    Checks that each draw goes out with the program it was meant for, when one program's
+    draws follow another's: an InstanceBatch drawing with its own instanced program, then
+    a SpriteBatch drawing with the scene's, frame after frame, as the levels do with the
+    enemies and the player. From the second frame on every uniform the SpriteBatch sets
+    is one the program already has, so nothing but the binds themselves can switch back.
+
+    tools/null_gl.cpp stands in for OpenGL and records the bound program at every draw.
+    This file stands in for the driver's instancing extensions, so the instanced path
+    runs without a context; with SDL linked as a shared library, these definitions of
+    SDL_GL_ExtensionSupported and SDL_GL_GetProcAddress are the ones InstanceBatch finds.
+
+    Build from AIPlatformer/SDLProject:
+        c++ -O2 -std=c++14 -I. $(sdl2-config --cflags) tools/render_state_test.cpp tools/null_gl.cpp \
+            InstanceBatch.cpp SpriteBatch.cpp ShaderProgram.cpp $(sdl2-config --libs) -o render_state_test
+    and run it from the same directory so the shaders are found:
+        ./render_state_test
+    Prints each failed check and exits 1 if there were any.
+*/
+#include <cstring>
+#include <iostream>
+#include "InstanceBatch.h"
+#include "SpriteBatch.h"
+#include "ShaderProgram.h"
+
+#define FRAME_COUNT 3
+#define ENEMY_COUNT 8
+
+constexpr char V_SHADER_PATH[] = "shaders/vertex_textured.glsl",
+               F_SHADER_PATH[] = "shaders/fragment_textured.glsl";
+
+// From tools/null_gl.cpp
+extern GLuint g_null_gl_bound_program,
+              g_null_gl_draw_program;
+
+static GLuint g_instanced_draw_program = 0;
+static int    g_failures               = 0;
+
+// ————— FAKE EXTENSIONS ————— //
+static void APIENTRY vertex_attrib_divisor(GLuint index, GLuint divisor) { }
+
+static void APIENTRY draw_arrays_instanced(GLenum mode, GLint first, GLsizei count, GLsizei instance_count)
+{
+    g_instanced_draw_program = g_null_gl_bound_program;
+}
+
+SDL_bool SDL_GL_ExtensionSupported(const char *extension)
+{
+    return strcmp(extension, "GL_ARB_instanced_arrays") == 0 || strcmp(extension, "GL_ARB_draw_instanced") == 0
+           ? SDL_TRUE : SDL_FALSE;
+}
+
+void *SDL_GL_GetProcAddress(const char *proc)
+{
+    if (strcmp(proc, "glVertexAttribDivisorARB") == 0) return (void *) &vertex_attrib_divisor;
+    if (strcmp(proc, "glDrawArraysInstancedARB") == 0) return (void *) &draw_arrays_instanced;
+
+    return nullptr;
+}
+
+static void check(bool condition, int frame, const char *what)
+{
+    if (condition) return;
+
+    std::cout << "frame " << frame << ": " << what << std::endl;
+    g_failures++;
+}
+
+int main()
+{
+    ShaderProgram program;
+    program.load(V_SHADER_PATH, F_SHADER_PATH);
+    program.set_projection_matrix(glm::ortho(-5.0f, 5.0f, -3.75f, 3.75f, -1.0f, 1.0f));
+    program.set_view_matrix(glm::mat4(1.0f));
+    program.use();
+
+    InstanceBatch enemies;
+    SpriteBatch   sprites;
+
+    for (int frame = 0; frame < FRAME_COUNT; frame++)
+    {
+        enemies.begin(1);
+        for (int i = 0; i < ENEMY_COUNT; i++) enemies.draw((float) i, 0.0f);
+        enemies.end(&program);
+
+        check(enemies.get_was_instanced(), frame, "the enemies weren't drawn instanced");
+        check(g_instanced_draw_program != 0 && g_instanced_draw_program != program.get_program_id(), frame,
+              "the instanced draw didn't use the instanced program");
+
+        sprites.begin();
+        sprites.draw(2, glm::mat4(1.0f), 0.0f, 0.0f, 1.0f, 1.0f);
+        sprites.end(&program);
+
+        check(g_null_gl_draw_program == program.get_program_id(), frame,
+              "the sprite batch after it drew with another program");
+    }
+
+    std::cout << (g_failures == 0 ? "All checks passed" : "Some checks failed") << std::endl;
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+/**
+    Benchmark for the texture cache: loads every image the way startup does, first by
+    decoding it with stb_image and then through its .texcache (see TextureFile.h), and
+    reports the median over a number of passes. Warm passes find the files in the OS's
+    page cache; cold passes evict them first, as after a reboot. The GL upload is the
+    same either way, so it's left out; instead every pixel is read once, which is what
+    faults a mapped cache in.
+
+    Run tools/texture_converter on the images first, or the cached side just falls back
+    to decoding and the two come out the same.
+
+    Build from AIPlatformer/SDLProject:
+        c++ -O2 -std=c++14 -I. tools/texture_benchmark.cpp TextureFile.cpp -o texture_benchmark
+    Usage:
+        ./texture_benchmark [--passes n] <image>...
+    Example, the images the platformer loads at startup:
+        ./texture_benchmark assets/DinoSprites.png assets/aiplatformerenemy.png assets/font1.png \
+            assets/tilemap_packed.png assets/platformPack_tile027.png
+*/
+#define STB_IMAGE_IMPLEMENTATION
+#define BYTES_PER_PIXEL 4
+#define DEFAULT_PASSES  20
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "stb_image.h"
+#include "TextureFile.h"
+
+#ifndef _WINDOWS
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Stands in for the upload: glTexImage2D reads every byte once
+static uint64_t read_pixels(const unsigned char *pixels, int width, int height)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < (size_t) width * height * BYTES_PER_PIXEL; i++) sum += pixels[i];
+
+    return sum;
+}
+
+// Drops the file's pages from the OS cache, so the next read goes to disk
+static bool evict(const std::string &filepath)
+{
+#ifdef _WINDOWS
+    return false;
+#else
+    int file = open(filepath.c_str(), O_RDONLY);
+    if (file < 0) return false;
+
+    // Only clean pages can go
+    fdatasync(file);
+    bool is_evicted = posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+
+    close(file);
+    return is_evicted;
+#endif
+}
+
+static double decode_all(const std::vector<const char *> &images, uint64_t *checksum)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (const char *image : images)
+    {
+        int width, height, number_of_components;
+        unsigned char *pixels = stbi_load(image, &width, &height, &number_of_components, STBI_rgb_alpha);
+        if (pixels == NULL) continue;
+
+        *checksum += read_pixels(pixels, width, height);
+        stbi_image_free(pixels);
+    }
+
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Falls back to stb_image for an image without a fresh cache, as the games do
+static double map_all(const std::vector<const char *> &images, uint64_t *checksum, int *cached_count)
+{
+    auto start = std::chrono::steady_clock::now();
+    *cached_count = 0;
+
+    for (const char *image : images)
+    {
+        TextureFile file(image);
+
+        if (file.get_is_loaded())
+        {
+            *checksum += read_pixels(file.get_pixels(), file.get_width(), file.get_height());
+            (*cached_count)++;
+            continue;
+        }
+
+        int width, height, number_of_components;
+        unsigned char *pixels = stbi_load(image, &width, &height, &number_of_components, STBI_rgb_alpha);
+        if (pixels == NULL) continue;
+
+        *checksum += read_pixels(pixels, width, height);
+        stbi_image_free(pixels);
+    }
+
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double median(std::vector<double> &times)
+{
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+int main(int argc, char* argv[])
+{
+    int passes = DEFAULT_PASSES;
+    std::vector<const char *> images;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--passes") == 0 && i + 1 < argc) passes = std::max(atoi(argv[++i]), 1);
+        else images.push_back(argv[i]);
+    }
+
+    if (images.empty())
+    {
+        std::cerr << "usage: " << argv[0] << " [--passes n] <image>..." << std::endl;
+        return 1;
+    }
+
+    bool can_evict = true;
+    for (const char *image : images) can_evict = evict(image) && can_evict;
+    if (!can_evict) std::cout << "Can't evict files from the OS cache here; cold passes are warm" << std::endl;
+
+    std::vector<double> cold_decode, warm_decode, cold_mapped, warm_mapped;
+    uint64_t decode_checksum = 0, mapped_checksum = 0;
+    int      cached_count    = 0;
+
+    for (int pass = 0; pass < passes; pass++)
+    {
+        for (const char *image : images)
+        {
+            evict(image);
+            evict(TextureFile::get_cache_path(image));
+        }
+
+        cold_decode.push_back(decode_all(images, &decode_checksum));
+        warm_decode.push_back(decode_all(images, &decode_checksum));
+
+        for (const char *image : images)
+        {
+            evict(image);
+            evict(TextureFile::get_cache_path(image));
+        }
+
+        cold_mapped.push_back(map_all(images, &mapped_checksum, &cached_count));
+        warm_mapped.push_back(map_all(images, &mapped_checksum, &cached_count));
+    }
+
+    std::cout << images.size() << " images, " << cached_count << " with a fresh .texcache, "
+              << passes << " passes, median ms" << std::endl;
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "          " << std::setw(10) << "decode" << std::setw(10) << "texcache" << std::setw(10) << "speedup" << "\n"
+              << "cold      " << std::setw(10) << median(cold_decode) << std::setw(10) << median(cold_mapped)
+              << std::setw(9) << median(cold_decode) / median(cold_mapped) << "x\n"
+              << "warm      " << std::setw(10) << median(warm_decode) << std::setw(10) << median(warm_mapped)
+              << std::setw(9) << median(warm_decode) / median(warm_mapped) << "x" << std::endl;
+
+    // Both sides read the same pixels, or one of them is wrong
+    if (decode_checksum != mapped_checksum)
+    {
+        std::cerr << "Pixels differ between the decoded images and their caches" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
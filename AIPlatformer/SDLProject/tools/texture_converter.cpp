@@ -0,0 +1,117 @@
+/**
+    Decodes images into .texcache files beside them, which the games map and upload
+    instead of decoding the images every launch (see TextureFile.h). A cache that's
+    already up to date with its image is left alone, so this can run on every build.
+
+    Build from AIPlatformer/SDLProject:
+        c++ -O2 -std=c++14 -I. tools/texture_converter.cpp TextureFile.cpp -o texture_converter
+
+    Usage:
+        ./texture_converter [options] <image>...
+    Options:
+        --premultiply   multiply colour by alpha before writing. The games blend straight
+                        alpha, so they decode the image rather than use a cache made with
+                        this; it's for a renderer that blends premultiplied.
+        --force         rewrite caches even when they're up to date
+    Example, the images the platformer loads at startup:
+        ./texture_converter assets/DinoSprites.png assets/aiplatformerenemy.png assets/font1.png \
+            assets/tilemap_packed.png assets/platformPack_tile027.png
+*/
+#define STB_IMAGE_IMPLEMENTATION
+#define BYTES_PER_PIXEL 4
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "stb_image.h"
+#include "TextureFile.h"
+
+static void premultiply(unsigned char *pixels, size_t pixel_count)
+{
+    for (size_t i = 0; i < pixel_count; i++)
+    {
+        unsigned char *pixel = pixels + i * BYTES_PER_PIXEL;
+        unsigned int   alpha = pixel[3];
+
+        // Rounded, so full alpha leaves the colour exactly as it was
+        for (int channel = 0; channel < 3; channel++) pixel[channel] = (unsigned char) ((pixel[channel] * alpha + 127) / 255);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t flags     = 0;
+    bool     is_forced = false;
+
+    std::vector<const char *> images;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if      (strcmp(argv[i], "--premultiply") == 0) flags |= TEXTURE_FLAG_PREMULTIPLIED;
+        else if (strcmp(argv[i], "--force") == 0)       is_forced = true;
+        else if (argv[i][0] == '-')
+        {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return 1;
+        }
+        else images.push_back(argv[i]);
+    }
+
+    if (images.empty())
+    {
+        std::cerr << "usage: " << argv[0] << " [--premultiply] [--force] <image>..." << std::endl;
+        return 1;
+    }
+
+    int written = 0, up_to_date = 0, failed = 0;
+
+    for (const char *image : images)
+    {
+        uint64_t source_size, source_hash;
+        if (!TextureFile::hash_file(image, &source_size, &source_hash))
+        {
+            std::cerr << "Unable to read " << image << std::endl;
+            failed++;
+            continue;
+        }
+
+        if (!is_forced)
+        {
+            TextureFile existing(image, flags);
+            if (existing.get_is_loaded())
+            {
+                up_to_date++;
+                continue;
+            }
+        }
+
+        int width, height, number_of_components;
+        unsigned char *pixels = stbi_load(image, &width, &height, &number_of_components, STBI_rgb_alpha);
+
+        if (pixels == NULL)
+        {
+            std::cerr << "Unable to decode " << image << ": " << stbi_failure_reason() << std::endl;
+            failed++;
+            continue;
+        }
+
+        if (flags & TEXTURE_FLAG_PREMULTIPLIED) premultiply(pixels, (size_t) width * height);
+
+        if (TextureFile::write(image, pixels, width, height, flags, source_size, source_hash))
+        {
+            std::cout << TextureFile::get_cache_path(image) << ": " << width << " x " << height << ", "
+                      << (size_t) width * height * BYTES_PER_PIXEL / 1024 << " KiB" << std::endl;
+            written++;
+        }
+        else
+        {
+            std::cerr << "Unable to write " << TextureFile::get_cache_path(image) << std::endl;
+            failed++;
+        }
+
+        stbi_image_free(pixels);
+    }
+
+    std::cout << written << " written, " << up_to_date << " up to date, " << failed << " failed" << std::endl;
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,343 @@
+#define GL_SILENCE_DEPRECATION
+#define GL_GLEXT_PROTOTYPES 1
+#define LOG(argument) std::cout << argument << '\n'
+#define MAX_DEPTH       32
+#define MAX_NAMES       64
+#define GPU_QUERY_COUNT 64
+#define AVERAGE_WEIGHT  0.05f   // how much each new frame moves the running average
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#include "Profiler.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengl.h>
+
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+
+struct OpenScope
+{
+    const char *name;
+    int64_t     start_ns;
+};
+
+struct ProfileName
+{
+    const char *name;
+    bool        is_gpu;
+    int64_t     frame_ns    = 0;
+    float       average_ms  = 0.0f;
+    bool        has_average = false;
+};
+
+struct PendingQuery
+{
+    GLuint      query;
+    const char *name;
+    uint32_t    frame;
+    int64_t     start_ns;
+};
+
+// glGetQueryObjectui64v isn't in every platform's GL headers, so it's looked up at run time
+typedef void (*GetQueryObjectUint64)(GLuint query, GLenum pname, uint64_t *params);
+
+static std::vector<ProfileSample> g_ring;
+static uint64_t                   g_written = 0;
+
+static OpenScope g_open[MAX_DEPTH];
+static int       g_depth = 0;
+static uint32_t  g_frame = 0;
+
+static std::thread::id g_owner;
+static bool            g_has_owner = false;
+
+static std::vector<ProfileName> g_names;
+
+static bool                     g_has_gpu     = false,
+                                g_is_gpu_open = false;
+static GetQueryObjectUint64     g_get_query_result = nullptr;
+static std::vector<GLuint>      g_free_queries;
+static std::deque<PendingQuery> g_pending;
+static PendingQuery             g_open_gpu;
+
+// ————— HELPERS ————— //
+static int64_t now_ns()
+{
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+static bool is_owner()
+{
+    if (!g_has_owner)
+    {
+        g_owner     = std::this_thread::get_id();
+        g_has_owner = true;
+    }
+
+    return std::this_thread::get_id() == g_owner;
+}
+
+static ProfileName *find_name(const char *name, bool is_gpu)
+{
+    for (ProfileName &entry : g_names)
+        if (entry.is_gpu == is_gpu && (entry.name == name || strcmp(entry.name, name) == 0)) return &entry;
+
+    if (g_names.size() >= MAX_NAMES) return nullptr;
+
+    ProfileName entry;
+    entry.name   = name;
+    entry.is_gpu = is_gpu;
+    g_names.push_back(entry);
+
+    return &g_names.back();
+}
+
+static void fold(ProfileName &entry, int64_t duration_ns)
+{
+    float ms = duration_ns / 1e6f;
+
+    entry.average_ms  = entry.has_average ? entry.average_ms + (ms - entry.average_ms) * AVERAGE_WEIGHT : ms;
+    entry.has_average = true;
+}
+
+static void record(const char *name, uint32_t frame, int depth, bool is_gpu, int64_t start_ns, int64_t duration_ns)
+{
+    if (g_ring.empty()) g_ring.resize(Profiler::RING_SIZE);
+
+    ProfileSample &sample = g_ring[g_written++ % Profiler::RING_SIZE];
+    sample.name        = name;
+    sample.frame       = frame;
+    sample.depth       = (uint8_t) depth;
+    sample.is_gpu      = is_gpu;
+    sample.start_ns    = start_ns;
+    sample.duration_ns = duration_ns;
+
+    ProfileName *entry = find_name(name, is_gpu);
+    if (entry == nullptr) return;
+
+    // CPU scopes add up over the frame and are averaged at its end; a GPU result turns
+    // up once, whenever the driver has it
+    if (is_gpu) fold(*entry, duration_ns);
+    else        entry->frame_ns += duration_ns;
+}
+
+// Oldest first
+template <typename Visit>
+static void for_each_sample(Visit visit)
+{
+    uint64_t first = g_written > Profiler::RING_SIZE ? g_written - Profiler::RING_SIZE : 0;
+
+    for (uint64_t i = first; i < g_written; i++) visit(g_ring[i % Profiler::RING_SIZE]);
+}
+
+// ————— GPU ————— //
+void Profiler::init_gpu()
+{
+    if (g_has_gpu) return;
+
+    if (SDL_GL_ExtensionSupported("GL_ARB_timer_query"))
+        g_get_query_result = (GetQueryObjectUint64) SDL_GL_GetProcAddress("glGetQueryObjectui64v");
+    else if (SDL_GL_ExtensionSupported("GL_EXT_timer_query"))
+        g_get_query_result = (GetQueryObjectUint64) SDL_GL_GetProcAddress("glGetQueryObjectui64vEXT");
+
+    if (g_get_query_result == nullptr)
+    {
+        LOG("Profiler: no GL timer queries, GPU scopes are off");
+        return;
+    }
+
+    g_free_queries.resize(GPU_QUERY_COUNT);
+    glGenQueries(GPU_QUERY_COUNT, g_free_queries.data());
+    g_has_gpu = true;
+}
+
+void Profiler::shutdown_gpu()
+{
+    if (!g_has_gpu) return;
+
+    if (g_is_gpu_open) end_gpu();
+    for (const PendingQuery &pending : g_pending) g_free_queries.push_back(pending.query);
+
+    glDeleteQueries((GLsizei) g_free_queries.size(), g_free_queries.data());
+
+    g_free_queries.clear();
+    g_pending.clear();
+    g_has_gpu = false;
+}
+
+void Profiler::begin_gpu(const char *name)
+{
+    if (!g_has_gpu || g_is_gpu_open || g_free_queries.empty() || !is_owner()) return;
+
+    g_open_gpu.query    = g_free_queries.back();
+    g_open_gpu.name     = name;
+    g_open_gpu.frame    = g_frame;
+    g_open_gpu.start_ns = now_ns();
+    g_free_queries.pop_back();
+
+    glBeginQuery(GL_TIME_ELAPSED, g_open_gpu.query);
+    g_is_gpu_open = true;
+}
+
+void Profiler::end_gpu()
+{
+    if (!g_is_gpu_open || !is_owner()) return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    g_pending.push_back(g_open_gpu);
+    g_is_gpu_open = false;
+}
+
+// Queries finish in the order they were issued, so stop at the first that hasn't
+static void collect_gpu_results()
+{
+    while (!g_pending.empty())
+    {
+        PendingQuery &pending = g_pending.front();
+
+        GLint available = 0;
+        glGetQueryObjectiv(pending.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) break;
+
+        uint64_t elapsed_ns = 0;
+        g_get_query_result(pending.query, GL_QUERY_RESULT, &elapsed_ns);
+
+        record(pending.name, pending.frame, 0, true, pending.start_ns, (int64_t) elapsed_ns);
+
+        g_free_queries.push_back(pending.query);
+        g_pending.pop_front();
+    }
+}
+
+// ————— FRAMES ————— //
+void Profiler::begin_frame()
+{
+    begin("frame");
+}
+
+void Profiler::end_frame()
+{
+    // Anything left open is closed here, so one missing end() can't skew every frame after
+    while (g_depth > 0) end();
+
+    for (ProfileName &entry : g_names)
+    {
+        if (entry.is_gpu) continue;
+
+        fold(entry, entry.frame_ns);
+        entry.frame_ns = 0;
+    }
+
+    if (g_has_gpu) collect_gpu_results();
+
+    g_frame++;
+}
+
+// ————— SCOPES ————— //
+void Profiler::begin(const char *name)
+{
+    if (!is_owner()) return;
+
+    // Past MAX_DEPTH we only count the depth, so the matching end()s still line up
+    if (g_depth < MAX_DEPTH) g_open[g_depth] = { name, now_ns() };
+    g_depth++;
+}
+
+void Profiler::end()
+{
+    if (g_depth == 0 || !is_owner()) return;
+
+    g_depth--;
+    if (g_depth >= MAX_DEPTH) return;
+
+    const OpenScope &scope = g_open[g_depth];
+    record(scope.name, g_frame, g_depth, false, scope.start_ns, now_ns() - scope.start_ns);
+}
+
+// ————— EXPORT ————— //
+bool Profiler::write_csv(const char *filepath)
+{
+    FILE *file = fopen(filepath, "w");
+    if (file == nullptr)
+    {
+        LOG("Unable to write profile " << filepath);
+        return false;
+    }
+
+    fprintf(file, "frame,name,timer,depth,start_us,duration_us\n");
+
+    for_each_sample([file](const ProfileSample &sample)
+    {
+        fprintf(file, "%u,%s,%s,%d,%.3f,%.3f\n", sample.frame, sample.name, sample.is_gpu ? "gpu" : "cpu",
+                sample.depth, sample.start_ns / 1e3, sample.duration_ns / 1e3);
+    });
+
+    fclose(file);
+    return true;
+}
+
+bool Profiler::write_chrome_trace(const char *filepath)
+{
+    FILE *file = fopen(filepath, "w");
+    if (file == nullptr)
+    {
+        LOG("Unable to write profile " << filepath);
+        return false;
+    }
+
+    // One track for the CPU scopes and one for the GPU ones
+    fprintf(file, "{\"traceEvents\":[\n"
+                  "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n"
+                  "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}");
+
+    for_each_sample([file](const ProfileSample &sample)
+    {
+        fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}",
+                sample.name, sample.is_gpu ? 2 : 1, sample.start_ns / 1e3, sample.duration_ns / 1e3, sample.frame);
+    });
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    return true;
+}
+
+// ————— GETTERS ————— //
+float const Profiler::get_average_ms(const char *name, bool is_gpu)
+{
+    for (const ProfileName &entry : g_names)
+        if (entry.is_gpu == is_gpu && strcmp(entry.name, name) == 0) return entry.average_ms;
+
+    return 0.0f;
+}
+
+int const Profiler::get_name_count()
+{
+    return (int) g_names.size();
+}
+
+const char *const Profiler::get_name(int index, bool *is_gpu)
+{
+    if (is_gpu != nullptr) *is_gpu = g_names[index].is_gpu;
+    return g_names[index].name;
+}
+
+uint32_t const Profiler::get_frame()
+{
+    return g_frame;
+}
+
+bool const Profiler::get_has_gpu_timers()
+{
+    return g_has_gpu;
+}
@@ -15,6 +15,11 @@
 #define GL_SILENCE_DEPRECATION
 #include "ShaderProgram.h"
 
+// GL has one bound program however many ShaderPrograms there are
+static GLuint g_bound_program = 0;
+
+static ShaderProgramStats g_stats;
+
 
 void ShaderProgram::load(const char *vertex_shader_file, const char *fragment_shader_file) {
     
@@ -42,6 +47,11 @@ void ShaderProgram::load(const char *vertex_shader_file, const char *fragment_sh
     m_view_matrix_uniform       = glGetUniformLocation(m_program_id, "viewMatrix");
     m_colour_uniform            = glGetUniformLocation(m_program_id, "color");
     
+    m_view_projection_matrix_uniform = glGetUniformLocation(m_program_id, "viewProjectionMatrix");
+    
+    // A new program starts with none of our uniforms set
+    m_has_model_matrix = m_has_view_matrix = m_has_projection_matrix = m_has_view_projection_matrix = m_has_colour = false;
+    
     m_position_attribute  = glGetAttribLocation(m_program_id, "position");
     m_tex_coord_attribute = glGetAttribLocation(m_program_id, "texCoord");
     
@@ -102,26 +112,138 @@ GLuint ShaderProgram::load_shader_from_string(const std::string &shaderContents,
     return shaderID;
 }
 
-void ShaderProgram::set_colour(float red, float green, float blue, float alpha)
+void ShaderProgram::use()
 {
+    if (g_bound_program == m_program_id)
+    {
+        g_stats.skipped++;
+        return;
+    }
+    
     glUseProgram(m_program_id);
+    g_bound_program = m_program_id;
+    g_stats.issued++;
+}
+
+void ShaderProgram::set_colour(float red, float green, float blue, float alpha)
+{
+    use();
+    
+    glm::vec4 colour = glm::vec4(red, green, blue, alpha);
+    
+    if (m_has_colour && colour == m_colour)
+    {
+        g_stats.skipped++;
+        return;
+    }
+    
     glUniform4f(m_colour_uniform, red, green, blue, alpha);
+    m_colour     = colour;
+    m_has_colour = true;
+    g_stats.issued++;
 }
 
 void ShaderProgram::set_view_matrix(const glm::mat4 &matrix)
 {
-    glUseProgram(m_program_id);
+    use();
+    
+    if (m_has_view_matrix && matrix == m_view_matrix)
+    {
+        g_stats.skipped++;
+        return;
+    }
+    
+    m_view_matrix     = matrix;
+    m_has_view_matrix = true;
+    
+    if (m_view_projection_matrix_uniform >= 0)
+    {
+        upload_view_projection();
+        return;
+    }
+    
     glUniformMatrix4fv(m_view_matrix_uniform, 1, GL_FALSE, &matrix[0][0]);
+    g_stats.issued++;
 }
 
 void ShaderProgram::set_model_matrix(const glm::mat4 &matrix)
 {
-    glUseProgram(m_program_id);
+    use();
+    
+    if (m_has_model_matrix && matrix == m_model_matrix)
+    {
+        g_stats.skipped++;
+        return;
+    }
+    
     glUniformMatrix4fv(m_model_matrix_uniform, 1, GL_FALSE, &matrix[0][0]);
+    m_model_matrix     = matrix;
+    m_has_model_matrix = true;
+    g_stats.issued++;
 }
 
 void ShaderProgram::set_projection_matrix(const glm::mat4 &matrix)
 {
-    glUseProgram(m_program_id);
+    use();
+    
+    if (m_has_projection_matrix && matrix == m_projection_matrix)
+    {
+        g_stats.skipped++;
+        return;
+    }
+    
+    m_projection_matrix     = matrix;
+    m_has_projection_matrix = true;
+    
+    if (m_view_projection_matrix_uniform >= 0)
+    {
+        upload_view_projection();
+        return;
+    }
+    
     glUniformMatrix4fv(m_projection_matrix_uniform, 1, GL_FALSE, &matrix[0][0]);
+    g_stats.issued++;
+}
+
+void ShaderProgram::set_view_projection_matrix(const glm::mat4 &view, const glm::mat4 &projection)
+{
+    use();
+    
+    if (m_view_projection_matrix_uniform < 0)
+    {
+        set_view_matrix(view);
+        set_projection_matrix(projection);
+        return;
+    }
+    
+    m_view_matrix           = view;
+    m_projection_matrix     = projection;
+    m_has_view_matrix       = true;
+    m_has_projection_matrix = true;
+    
+    upload_view_projection();
+}
+
+// Nothing to upload until both halves have been set; the setters calling this have bound the program
+void ShaderProgram::upload_view_projection()
+{
+    if (!m_has_view_matrix || !m_has_projection_matrix) return;
+    
+    glm::mat4 matrix = m_projection_matrix * m_view_matrix;
+    
+    if (m_has_view_projection_matrix && matrix == m_view_projection_matrix)
+    {
+        g_stats.skipped++;
+        return;
+    }
+    
+    glUniformMatrix4fv(m_view_projection_matrix_uniform, 1, GL_FALSE, &matrix[0][0]);
+    m_view_projection_matrix     = matrix;
+    m_has_view_projection_matrix = true;
+    g_stats.issued++;
+}
+
+ShaderProgramStats const ShaderProgram::get_stats()
+{
+    return g_stats;
 }
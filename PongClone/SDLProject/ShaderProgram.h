@@ -14,16 +14,36 @@
 #endif
 #define GL_GLEXT_PROTOTYPES 1
 #include <SDL_opengl.h>
+#include <stdint.h>
 #include <string>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include "glm/mat4x4.hpp"
+#include "glm/vec4.hpp"
 
+struct ShaderProgramStats
+{
+    uint64_t issued  = 0,     // glUseProgram and glUniform* calls that reached GL
+             skipped = 0;     // ones dropped because GL already had that state
+};
+
+/**
+    Shadows the bound program and every uniform it has uploaded, and skips the GL call
+    when a setter is handed what GL already has. That only holds while all the binds go
+    through use(), so nothing else should call glUseProgram. Every setter binds its program
+    first, even when the value it's handed is already there, so setting a uniform is
+    enough to switch back to a program after another one has drawn.
+    
+    A shader that declares viewProjectionMatrix gets projection * view multiplied once
+    here, instead of for every vertex, and one upload where there were two; one with
+    separate viewMatrix and projectionMatrix uniforms still gets those.
+*/
 class ShaderProgram
 {
 private:
     void cleanup();
+    void upload_view_projection();
     
     GLuint load_shader_from_string(const std::string &shader_contents, GLenum shader_type);
     GLuint load_shader_from_file(const std::string &shader_file, GLenum shader_type);
@@ -34,6 +54,19 @@ private:
     GLuint m_model_matrix_uniform;
     GLuint m_view_matrix_uniform;
     GLuint m_colour_uniform;
+    GLint  m_view_projection_matrix_uniform = -1;
+    
+    // ————— SHADOWED STATE ————— //
+    glm::mat4 m_model_matrix,
+              m_view_matrix,
+              m_projection_matrix,
+              m_view_projection_matrix;
+    glm::vec4 m_colour;
+    bool      m_has_model_matrix           = false,
+              m_has_view_matrix            = false,
+              m_has_projection_matrix      = false,
+              m_has_view_projection_matrix = false,
+              m_has_colour                 = false;
 
     GLuint m_position_attribute;
     GLuint m_tex_coord_attribute;
@@ -44,15 +77,26 @@ private:
 public:
 
     void load(const char *vertex_shader_file, const char *fragment_shader_file);
+    
+    // Binds the program, unless it already is
+    void use();
 
     void set_model_matrix(const glm::mat4 &matrix);
     void set_projection_matrix(const glm::mat4 &matrix);
     void set_view_matrix(const glm::mat4 &matrix);
+    void set_view_projection_matrix(const glm::mat4 &view, const glm::mat4 &projection);
     void set_colour(float red, float green, float blue, float alpha);
     
+    // Counted over every program since the start
+    static ShaderProgramStats const get_stats();
+    
     GLuint const get_program_id()               const { return m_program_id;          };
     GLuint const get_position_attribute()       const { return m_position_attribute;  };
     GLuint const get_tex_coordinate_attribute() const { return m_tex_coord_attribute; };
     
+    // The last ones set, whether they went to GL as one matrix or two
+    glm::mat4 const &get_view_matrix()       const { return m_view_matrix;       };
+    glm::mat4 const &get_projection_matrix() const { return m_projection_matrix; };
+    
     void set_program_id(GLuint program_id)                         { m_program_id = program_id;                   };
 };
@@ -1,6 +1,7 @@
 #define GL_SILENCE_DEPRECATION
 #define STB_IMAGE_IMPLEMENTATION
 #define LOG(argument) std::cout << argument << '\n'
+#define FIXED_TIMESTEP 0.0166666f
 
 #ifdef _WINDOWS
 #include <GL/glew.h>
@@ -15,9 +16,17 @@
 #include "stb_image.h"
 #include "cmath"
 #include <ctime>
+#include <cstring>
+#include "Input.h"
+#include "Profiler.h"
+#include "TextureAtlas.h"
 
 enum AppStatus { RUNNING, TERMINATED };
 
+// What Input hands each step, by the bit it sits at
+enum GameButton { BUTTON_RED_UP, BUTTON_RED_DOWN, BUTTON_BLUE_UP, BUTTON_BLUE_DOWN, BUTTON_SERVE,
+                  BUTTON_ONE_PLAYER, BUTTON_TWO_PLAYER, BUTTON_QUIT };
+
 constexpr float WINDOW_SIZE_MULT = 1.5f;
 
 constexpr int WINDOW_WIDTH  = 640 * WINDOW_SIZE_MULT,
@@ -36,10 +45,6 @@ constexpr int VIEWPORT_X = 0,
 constexpr char V_SHADER_PATH[] = "shaders/vertex_textured.glsl",
            F_SHADER_PATH[] = "shaders/fragment_textured.glsl";
 
-constexpr GLint NUMBER_OF_TEXTURES = 1;
-constexpr GLint LEVEL_OF_DETAIL    = 0;
-constexpr GLint TEXTURE_BORDER     = 0;
-
 constexpr float MILLISECONDS_IN_SECOND = 1000.0;
 
 constexpr char BLUE_SPRITE_FILEPATH[] = "rectangle_blue_real.png",
@@ -61,10 +66,22 @@ ShaderProgram g_shader_program = ShaderProgram();
 glm::mat4 g_view_matrix, g_BLUE_matrix, g_projection_matrix, g_RED_matrix, g_BALL_matrix;
 
 float g_previous_ticks = 0.0f;
+float g_accumulator = 0.0f;
+
+Input g_input;
 
-GLuint g_BLUE_texture_id;
-GLuint g_RED_texture_id;
-GLuint g_BALL_texture_id;
+// Replays a log with no window on screen and no rendering, as fast as the steps go
+bool g_is_headless = false;
+
+// Where the profiler's samples go on the way out, if anywhere
+const char *g_profile_csv_path   = nullptr,
+           *g_profile_trace_path = nullptr;
+
+// Both paddles and the ball are packed into one texture, so drawing them never switches
+TextureAtlas* g_atlas;
+const AtlasSprite* g_BLUE_sprite;
+const AtlasSprite* g_RED_sprite;
+const AtlasSprite* g_BALL_sprite;
 
 
 constexpr float PADDLE_SPEED = 3.0f;
@@ -97,45 +114,18 @@ bool start = false;
 
 void initialise();
 void process_input();
+void step();
 void update();
 void render();
 void shutdown();
 
-GLuint load_texture(const char* filepath)
-{
-    // STEP 1: Loading the image file
-    int width, height, number_of_components;
-    unsigned char* image = stbi_load(filepath, &width, &height, &number_of_components, STBI_rgb_alpha);
-
-    if (image == NULL)
-    {
-        LOG("Unable to load image. Make sure the path is correct.");
-        assert(false);
-    }
-
-    // STEP 2: Generating and binding a texture ID to our image
-    GLuint textureID;
-    glGenTextures(NUMBER_OF_TEXTURES, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL, GL_RGBA, width, height, TEXTURE_BORDER, GL_RGBA, GL_UNSIGNED_BYTE, image);
-
-    // STEP 3: Setting our texture filter parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    // STEP 4: Releasing our file from memory and returning our texture id
-    stbi_image_free(image);
-
-    return textureID;
-}
-
 void initialise()
 {
     SDL_Init(SDL_INIT_VIDEO);
     g_display_window = SDL_CreateWindow("Pong Clone",
                                       SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
                                       WINDOW_WIDTH, WINDOW_HEIGHT,
-                                      SDL_WINDOW_OPENGL);
+                                      SDL_WINDOW_OPENGL | (g_is_headless ? SDL_WINDOW_HIDDEN : 0));
 
     SDL_GLContext context = SDL_GL_CreateContext(g_display_window);
     SDL_GL_MakeCurrent(g_display_window, context);
@@ -147,6 +137,8 @@ void initialise()
     glewInit();
 #endif
 
+    Profiler::init_gpu();
+
     glViewport(VIEWPORT_X, VIEWPORT_Y, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
 
     g_shader_program.load(V_SHADER_PATH, F_SHADER_PATH);
@@ -164,13 +156,34 @@ void initialise()
     g_shader_program.set_projection_matrix(g_projection_matrix);
     g_shader_program.set_view_matrix(g_view_matrix);
 
-    glUseProgram(g_shader_program.get_program_id());
+    g_shader_program.use();
 
     glClearColor(BG_RED, BG_BLUE, BG_GREEN, BG_OPACITY);
 
-    g_BLUE_texture_id = load_texture(BLUE_SPRITE_FILEPATH);
-    g_RED_texture_id = load_texture(RED_SPRITE_FILEPATH);
-    g_BALL_texture_id = load_texture(BALL_SPRITE_FILEPATH);
+    g_atlas = new TextureAtlas();
+    g_atlas->add(BLUE_SPRITE_FILEPATH);
+    g_atlas->add(RED_SPRITE_FILEPATH);
+    g_atlas->add(BALL_SPRITE_FILEPATH);
+    g_atlas->build();
+
+    g_BLUE_sprite = g_atlas->find(BLUE_SPRITE_FILEPATH);
+    g_RED_sprite = g_atlas->find(RED_SPRITE_FILEPATH);
+    g_BALL_sprite = g_atlas->find(BALL_SPRITE_FILEPATH);
+
+    if (g_BLUE_sprite == NULL || g_RED_sprite == NULL || g_BALL_sprite == NULL)
+    {
+        LOG("Unable to load image. Make sure the path is correct.");
+        assert(false);
+    }
+
+    g_input.bind(BUTTON_RED_UP,     SDL_SCANCODE_W);
+    g_input.bind(BUTTON_RED_DOWN,   SDL_SCANCODE_S);
+    g_input.bind(BUTTON_BLUE_UP,    SDL_SCANCODE_UP);
+    g_input.bind(BUTTON_BLUE_DOWN,  SDL_SCANCODE_DOWN);
+    g_input.bind(BUTTON_SERVE,      SDL_SCANCODE_SPACE);
+    g_input.bind(BUTTON_ONE_PLAYER, SDL_SCANCODE_T);
+    g_input.bind(BUTTON_TWO_PLAYER, SDL_SCANCODE_Y);
+    g_input.bind(BUTTON_QUIT,       SDL_SCANCODE_Q);
 
     // enable blending
     glEnable(GL_BLEND);
@@ -181,47 +194,39 @@ void initialise()
 
 void process_input()
 {
+    PROFILE_SCOPE("input");
+
+    // The keys themselves are read a step at a time, in step()
+    g_input.poll();
 
-    SDL_Event event;
-    while (SDL_PollEvent(&event))
+    if (g_input.get_is_quitting()) g_app_status = TERMINATED;
+}
+
+// One fixed step: this step's keys, the bounces, then everything moves
+void step()
+{
+    PROFILE_SCOPE("step");
+
+    InputSnapshot input = g_input.next_step();
+
+    // A replay that has run out of input is over
+    if (g_input.get_is_finished() || input.was_pressed(BUTTON_QUIT))
     {
-        switch (event.type)
-        {
-
-            // End game
-            case SDL_QUIT:
-            case SDL_WINDOWEVENT_CLOSE:
-                g_app_status = TERMINATED;
-                break;
-
-            case SDL_KEYDOWN:
-                switch (event.key.keysym.sym)
-                {
-                    case SDLK_q: g_app_status = TERMINATED; break;
-                    default: break;
-                }
-                
-                
-
-            default:
-                break;
-                
-        }
+        g_app_status = TERMINATED;
+        return;
     }
-    
+
      g_RED_movement.y = 0.0f;
     
-     const Uint8 *key_state = SDL_GetKeyboardState(NULL);
-    
-    if (key_state[SDL_SCANCODE_SPACE]){
+    if (input.is_held(BUTTON_SERVE)){
         g_BALL_movement.x = -0.5;
         g_BALL_movement.y = 0.5;
     }
     
-     if (key_state[SDL_SCANCODE_W] and red_at_ceiling == false){
+     if (input.is_held(BUTTON_RED_UP) and red_at_ceiling == false){
          g_RED_movement.y = 1.0f;
      }
-     else if (key_state[SDL_SCANCODE_S] and red_at_floor == false){
+     else if (input.is_held(BUTTON_RED_DOWN) and red_at_floor == false){
          g_RED_movement.y = -1.0f;
      }
     
@@ -239,10 +244,10 @@ void process_input()
          red_at_floor = false;
      }
     
-    if (key_state[SDL_SCANCODE_T]){
+    if (input.is_held(BUTTON_ONE_PLAYER)){
         single_player = true;
     }
-    if (key_state[SDL_SCANCODE_Y]){
+    if (input.is_held(BUTTON_TWO_PLAYER)){
         single_player = false;
     }
     
@@ -264,10 +269,10 @@ void process_input()
     if (single_player == false)
     {
         g_BLUE_movement.y = 0.0f;
-        if (key_state[SDL_SCANCODE_UP] and blue_at_ceiling == false){
+        if (input.is_held(BUTTON_BLUE_UP) and blue_at_ceiling == false){
             g_BLUE_movement.y = 1.0f;
         }
-        else if (key_state[SDL_SCANCODE_DOWN] and blue_at_floor == false){
+        else if (input.is_held(BUTTON_BLUE_DOWN) and blue_at_floor == false){
             g_BLUE_movement.y = -1.0f;
         }
         
@@ -366,10 +371,18 @@ void process_input()
         
         
     }
+
+    if (game_running == false) return;
+
+    g_RED_position += g_RED_movement * PADDLE_SPEED * FIXED_TIMESTEP;
+    g_BLUE_position += g_BLUE_movement * PADDLE_SPEED * FIXED_TIMESTEP;
+    g_BALL_position += g_BALL_movement * BALL_SPEED * FIXED_TIMESTEP;
 }
 
 void update()
 {
+    PROFILE_SCOPE("update");
+
     
     // --- DELTA TIME CALCULATIONS --- //
     float ticks = (float) SDL_GetTicks() / MILLISECONDS_IN_SECOND;
@@ -379,9 +392,17 @@ void update()
 
 
     // --- ACCUMULATOR LOGIC --- //
-    g_RED_position += g_RED_movement * PADDLE_SPEED * delta_time;
-    g_BLUE_position += g_BLUE_movement * PADDLE_SPEED * delta_time;
-    g_BALL_position += g_BALL_movement * BALL_SPEED * delta_time;
+    // Stepping at a fixed rate is what lets a recorded game replay the same way
+    delta_time += g_accumulator;
+
+    while (delta_time >= FIXED_TIMESTEP && game_running && g_app_status == RUNNING)
+    {
+        step();
+
+        delta_time -= FIXED_TIMESTEP;
+    }
+
+    g_accumulator = delta_time;
     
     
 
@@ -407,63 +428,135 @@ void update()
 
 }
 
-void draw_object(glm::mat4 &object_model_matrix, GLuint &object_texture_id)
+void draw_object(glm::mat4 &object_model_matrix, const AtlasSprite &object_sprite)
 {
+    // Each object only shows its own corner of the atlas
+    const AtlasRegion &region = object_sprite.region;
+    float left   = region.u,
+          right  = region.u + region.width,
+          top    = region.v,
+          bottom = region.v + region.height;
+
+    float texture_coordinates[] = {
+        left, bottom, right, bottom, right, top,    // triangle 1
+        left, bottom, right, top,    left,  top,    // triangle 2
+    };
+
+    glVertexAttribPointer(g_shader_program.get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, texture_coordinates);
+
     g_shader_program.set_model_matrix(object_model_matrix);
-    glBindTexture(GL_TEXTURE_2D, object_texture_id);
+    glBindTexture(GL_TEXTURE_2D, object_sprite.texture_id);
     glDrawArrays(GL_TRIANGLES, 0, 6); // we are now drawing 2 triangles, so we use 6 instead of 3
 }
 
 void render() {
-    glClear(GL_COLOR_BUFFER_BIT);
+    {
+        PROFILE_SCOPE("render");
+        PROFILE_GPU_SCOPE("render");
 
-    // Vertices
-    float vertices[] = {
-        -0.5f, -0.5f, 0.5f, -0.5f, 0.5f, 0.5f,  // triangle 1
-        -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f   // triangle 2
-    };
+        glClear(GL_COLOR_BUFFER_BIT);
 
-    // Textures
-    float texture_coordinates[] = {
-        0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,     // triangle 1
-        0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f,     // triangle 2
-    };
+        // Vertices
+        float vertices[] = {
+            -0.5f, -0.5f, 0.5f, -0.5f, 0.5f, 0.5f,  // triangle 1
+            -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f   // triangle 2
+        };
 
-    glVertexAttribPointer(g_shader_program.get_position_attribute(), 2, GL_FLOAT, false, 0, vertices);
-    glEnableVertexAttribArray(g_shader_program.get_position_attribute());
+        glVertexAttribPointer(g_shader_program.get_position_attribute(), 2, GL_FLOAT, false, 0, vertices);
+        glEnableVertexAttribArray(g_shader_program.get_position_attribute());
 
-    glVertexAttribPointer(g_shader_program.get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, texture_coordinates);
-    glEnableVertexAttribArray(g_shader_program.get_tex_coordinate_attribute());
+        // Textures: draw_object points this at each object's part of the atlas
+        glEnableVertexAttribArray(g_shader_program.get_tex_coordinate_attribute());
 
-    // Bind texture
-    draw_object(g_RED_matrix, g_RED_texture_id);
-    draw_object(g_BLUE_matrix, g_BLUE_texture_id);
-    draw_object(g_BALL_matrix, g_BALL_texture_id);
+        draw_object(g_RED_matrix, *g_RED_sprite);
+        draw_object(g_BLUE_matrix, *g_BLUE_sprite);
+        draw_object(g_BALL_matrix, *g_BALL_sprite);
 
-    // We disable two attribute arrays now
-    glDisableVertexAttribArray(g_shader_program.get_position_attribute());
-    glDisableVertexAttribArray(g_shader_program.get_tex_coordinate_attribute());
+        // We disable two attribute arrays now
+        glDisableVertexAttribArray(g_shader_program.get_position_attribute());
+        glDisableVertexAttribArray(g_shader_program.get_tex_coordinate_attribute());
+    }
 
+    PROFILE_SCOPE("swap");
     SDL_GL_SwapWindow(g_display_window);
 }
 
-void shutdown() { SDL_Quit(); }
+void shutdown()
+{
+    g_input.close();
+
+    if (g_profile_csv_path   != nullptr) Profiler::write_csv(g_profile_csv_path);
+    if (g_profile_trace_path != nullptr) Profiler::write_chrome_trace(g_profile_trace_path);
+    Profiler::shutdown_gpu();
+
+    delete g_atlas;
+    SDL_Quit();
+}
+
 
+// Replays the log step after step with nothing drawn, then reports where it ended up
+void run_headless()
+{
+    Uint32 start_ticks = SDL_GetTicks();
+
+    // Each step is a frame as far as the profiler is concerned
+    while (g_app_status == RUNNING && game_running)
+    {
+        Profiler::begin_frame();
+        step();
+        Profiler::end_frame();
+    }
+
+    float seconds = (SDL_GetTicks() - start_ticks) / MILLISECONDS_IN_SECOND;
+
+    std::cout << "steps: " << g_input.get_step() << '\n'
+              << "result: " << (red_win ? "red wins" : blue_win ? "blue wins" : "unfinished") << '\n'
+              << "ball: " << g_BALL_position.x << ", " << g_BALL_position.y << '\n';
+    if (seconds > 0.0f) std::cout << "speed: " << g_input.get_step() * FIXED_TIMESTEP / seconds << "x real time\n";
+}
 
 int main(int argc, char* argv[])
 {
+    for (int i = 1; i < argc; i++)
+    {
+        bool has_value = i + 1 < argc;
+
+        // Every fixed step's keys, to a log or back out of one
+        if      (strcmp(argv[i], "--record") == 0 && has_value && !g_input.record(argv[++i])) return 1;
+        else if (strcmp(argv[i], "--replay") == 0 && has_value && !g_input.replay(argv[++i])) return 1;
+        else if (strcmp(argv[i], "--headless") == 0) g_is_headless = true;
+
+        // The last Profiler::RING_SIZE timings, as a CSV or a Chrome trace
+        else if (strcmp(argv[i], "--profile-csv")   == 0 && has_value) g_profile_csv_path   = argv[++i];
+        else if (strcmp(argv[i], "--profile-trace") == 0 && has_value) g_profile_trace_path = argv[++i];
+    }
+
+    if (g_is_headless && g_input.get_mode() != Input::REPLAYING)
+    {
+        LOG("--headless needs a log to --replay");
+        return 1;
+    }
+
     initialise();
 
+    if (g_is_headless)
+    {
+        run_headless();
+        shutdown();
+        return 0;
+    }
+
     while (g_app_status == RUNNING)
     {
+        Profiler::begin_frame();
+
             process_input();
         if(game_running == true){
             update();
         }
             render();
-        
-        
-        
+
+        Profiler::end_frame();
     }
 
     shutdown();
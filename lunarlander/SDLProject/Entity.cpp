@@ -119,13 +119,13 @@ Entity::~Entity() { }
 
 void Entity::draw_sprite_from_texture_atlas(ShaderProgram* program, GLuint texture_id, int index)
 {
-    // Step 1: Calculate the UV location of the indexed frame
-    float u_coord = (float)(index % m_animation_cols) / (float)m_animation_cols;
-    float v_coord = (float)(index / m_animation_cols) / (float)m_animation_rows;
+    // Step 1: Calculate the UV location of the indexed frame, within the sheet's atlas region
+    float u_coord = m_atlas_region.map_u((float)(index % m_animation_cols) / (float)m_animation_cols);
+    float v_coord = m_atlas_region.map_v((float)(index / m_animation_cols) / (float)m_animation_rows);
 
     // Step 2: Calculate its UV size
-    float width = 1.0f / (float)m_animation_cols;
-    float height = 1.0f / (float)m_animation_rows;
+    float width = m_atlas_region.width / (float)m_animation_cols;
+    float height = m_atlas_region.height / (float)m_animation_rows;
 
     // Step 3: Just as we have done before, match the texture coordinates to the vertices
     float tex_coords[] =
@@ -304,8 +304,13 @@ void Entity::render(ShaderProgram* program)
         return;
     }
 
+    float left   = m_atlas_region.u,
+          right  = m_atlas_region.u + m_atlas_region.width,
+          top    = m_atlas_region.v,
+          bottom = m_atlas_region.v + m_atlas_region.height;
+
     float vertices[] = { -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, -0.5, 0.5, 0.5, -0.5, 0.5 };
-    float tex_coords[] = { 0.0,  1.0, 1.0,  1.0, 1.0, 0.0,  0.0,  1.0, 1.0, 0.0,  0.0, 0.0 };
+    float tex_coords[] = { left, bottom, right, bottom, right, top, left, bottom, right, top, left, top };
 
     glBindTexture(GL_TEXTURE_2D, m_texture_id);
 
@@ -319,3 +324,20 @@ void Entity::render(ShaderProgram* program)
     glDisableVertexAttribArray(program->get_position_attribute());
     glDisableVertexAttribArray(program->get_tex_coordinate_attribute());
 }
+
+void Entity::render(SpriteBatch* batch)
+{
+    if (m_animation_indices != NULL)
+    {
+        int index = m_animation_indices[m_animation_index];
+
+        float u_coord = m_atlas_region.map_u((float)(index % m_animation_cols) / (float)m_animation_cols);
+        float v_coord = m_atlas_region.map_v((float)(index / m_animation_cols) / (float)m_animation_rows);
+
+        batch->draw(m_texture_id, m_model_matrix, u_coord, v_coord,
+                    m_atlas_region.width / (float)m_animation_cols, m_atlas_region.height / (float)m_animation_rows);
+        return;
+    }
+
+    batch->draw(m_texture_id, m_model_matrix, m_atlas_region.u, m_atlas_region.v, m_atlas_region.width, m_atlas_region.height);
+}
@@ -3,6 +3,8 @@
 
 #include "glm/glm.hpp"
 #include "ShaderProgram.h"
+#include "SpriteBatch.h"
+#include "TextureAtlas.h"
 enum EntityType { PLATFORM, PLAYER, ENEMY, LAVA  };
 enum AIType     { WALKER, GUARD            };
 enum AIState    { WALKING, IDLE, ATTACKING };
@@ -45,6 +47,10 @@ private:
     // ————— TEXTURES ————— //
     GLuint    m_texture_id;
 
+    // The part of m_texture_id this entity's image takes up, if it was packed into an
+    // atlas; animation frames are cut out of this rather than the whole texture
+    AtlasRegion m_atlas_region;
+
     // ————— ANIMATION ————— //
     int m_animation_cols;
     int m_animation_frames,
@@ -82,6 +88,7 @@ public:
     void const check_collision_x(Entity* collidable_entities, int collidable_entity_count);
     void update(float delta_time, Entity *player, Entity *collidable_entities, int collidable_entity_count);
     void render(ShaderProgram* program);
+    void render(SpriteBatch* batch);
 
     void ai_activate(Entity *player);
     void ai_walk();
@@ -134,6 +141,7 @@ public:
     glm::vec3 const get_movement()     const { return m_movement; }
     glm::vec3 const get_scale()        const { return m_scale; }
     GLuint    const get_texture_id()   const { return m_texture_id; }
+    AtlasRegion const get_atlas_region() const { return m_atlas_region; }
     float     const get_speed()        const { return m_speed; }
     bool      const get_collided_top() const { return m_collided_top; }
     bool      const get_collided_bottom() const { return m_collided_bottom; }
@@ -161,6 +169,7 @@ public:
     void const set_movement(glm::vec3 new_movement) { m_movement = new_movement; }
     void const set_scale(glm::vec3 new_scale) { m_scale = new_scale; }
     void const set_texture_id(GLuint new_texture_id) { m_texture_id = new_texture_id; }
+    void const set_atlas_region(const AtlasRegion &new_region) { m_atlas_region = new_region; }
     void const set_speed(float new_speed) { m_speed = new_speed; }
     void const set_animation_cols(int new_cols) { m_animation_cols = new_cols; }
     void const set_animation_rows(int new_rows) { m_animation_rows = new_rows; }
@@ -0,0 +1,204 @@
+#define LOG(argument) std::cout << argument << '\n'
+
+#include "Input.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+Input::Input()
+{
+    for (int i = 0; i < MAX_BUTTONS; i++) m_bindings[i] = SDL_SCANCODE_UNKNOWN;
+}
+
+Input::~Input()
+{
+    close();
+}
+
+void Input::bind(int button, SDL_Scancode key)
+{
+    if (button < 0 || button >= MAX_BUTTONS) return;
+    
+    m_bindings[button] = key;
+    m_binding_count    = std::max(m_binding_count, button + 1);
+}
+
+// ————— LOG ————— //
+bool Input::record(const char *filepath)
+{
+    m_file = fopen(filepath, "wb");
+    if (m_file == NULL)
+    {
+        LOG("Unable to write input log " << filepath);
+        return false;
+    }
+    
+    // A placeholder until close() knows the counts
+    InputLogHeader header = {};
+    fwrite(&header, sizeof(header), 1, m_file);
+    
+    m_mode = RECORDING;
+    return true;
+}
+
+bool Input::replay(const char *filepath)
+{
+    FILE *file = fopen(filepath, "rb");
+    if (file == NULL)
+    {
+        LOG("Unable to open input log " << filepath);
+        return false;
+    }
+    
+    InputLogHeader header;
+    bool is_valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                    memcmp(header.magic, INPUT_LOG_MAGIC, sizeof(header.magic)) == 0 &&
+                    header.version == INPUT_LOG_VERSION;
+    
+    // The runs have to fit in what's left of the file before anything is allocated for
+    // them, or a damaged count could ask for more memory than there is
+    if (is_valid)
+    {
+        long runs_start = ftell(file);
+        is_valid = runs_start >= 0 && fseek(file, 0, SEEK_END) == 0;
+        
+        long file_size = is_valid ? ftell(file) : -1;
+        is_valid = file_size >= runs_start &&
+                   (uint64_t) header.run_count * sizeof(InputRun) <= (uint64_t) (file_size - runs_start) &&
+                   fseek(file, runs_start, SEEK_SET) == 0;
+    }
+    
+    if (is_valid)
+    {
+        m_runs.resize(header.run_count);
+        is_valid = fread(m_runs.data(), sizeof(InputRun), header.run_count, file) == header.run_count;
+    }
+    fclose(file);
+    
+    if (!is_valid)
+    {
+        LOG("Input log " << filepath << " is damaged or from another version");
+        m_runs.clear();
+        return false;
+    }
+    
+    m_mode = REPLAYING;
+    return true;
+}
+
+void Input::write_pending()
+{
+    if (m_pending.steps == 0) return;
+    
+    fwrite(&m_pending, sizeof(m_pending), 1, m_file);
+    m_runs_written++;
+    m_pending.steps = 0;
+}
+
+void Input::close()
+{
+    if (m_file == NULL) return;
+    
+    write_pending();
+    
+    InputLogHeader header;
+    memcpy(header.magic, INPUT_LOG_MAGIC, sizeof(header.magic));
+    header.version    = INPUT_LOG_VERSION;
+    header.step_count = (uint32_t) m_step;
+    header.run_count  = m_runs_written;
+    
+    fseek(m_file, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, m_file);
+    fclose(m_file);
+    
+    m_file = NULL;
+    m_mode = LIVE;
+}
+
+// ————— STEPPING ————— //
+void Input::poll()
+{
+    SDL_Event event;
+    while (SDL_PollEvent(&event))
+    {
+        switch (event.type)
+        {
+            case SDL_QUIT:
+            case SDL_WINDOWEVENT_CLOSE:
+                m_is_quitting = true;
+                break;
+                
+            case SDL_KEYDOWN:
+                if (m_mode == REPLAYING) break;
+                
+                for (int i = 0; i < m_binding_count; i++)
+                    if (m_bindings[i] == event.key.keysym.scancode) press(i);
+                break;
+                
+            default:
+                break;
+        }
+    }
+    
+    if (m_mode == REPLAYING) return;
+    
+    const Uint8 *key_state = SDL_GetKeyboardState(NULL);
+    
+    for (int i = 0; i < m_binding_count; i++)
+        if (m_bindings[i] != SDL_SCANCODE_UNKNOWN) set_held(i, key_state[m_bindings[i]]);
+}
+
+InputSnapshot Input::next_step()
+{
+    InputSnapshot snapshot;
+    
+    if (m_mode == REPLAYING)
+    {
+        // Past the end it's as if every key had been let go
+        if (m_run >= m_runs.size())
+        {
+            m_is_finished = true;
+            return snapshot;
+        }
+        
+        snapshot.held    = m_runs[m_run].held;
+        snapshot.pressed = m_runs[m_run].pressed;
+        
+        if (++m_run_step >= m_runs[m_run].steps)
+        {
+            m_run++;
+            m_run_step = 0;
+        }
+        
+        m_step++;
+        return snapshot;
+    }
+    
+    // A press lasts until a step has seen it, even across frames that ran no steps
+    snapshot = m_live;
+    m_live.pressed = 0;
+    
+    if (m_mode == RECORDING)
+    {
+        if (m_pending.steps > 0 && (m_pending.held != snapshot.held || m_pending.pressed != snapshot.pressed))
+            write_pending();
+        
+        m_pending.held    = snapshot.held;
+        m_pending.pressed = snapshot.pressed;
+        m_pending.steps++;
+    }
+    
+    m_step++;
+    return snapshot;
+}
+
+void Input::set_held(int button, bool is_held)
+{
+    if (is_held) m_live.held |=  (uint16_t) (1 << button);
+    else         m_live.held &= (uint16_t) ~(1 << button);
+}
+
+void Input::press(int button)
+{
+    m_live.pressed |= (uint16_t) (1 << button);
+}
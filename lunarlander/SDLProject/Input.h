@@ -0,0 +1,111 @@
+#pragma once
+#include <stdint.h>
+#include <cstdio>
+#include <vector>
+#include <SDL.h>
+
+/**
+    What a fixed step sees of the keyboard: the buttons held down, and the ones pressed
+    since the step before (a held key's repeats count as presses, as SDL_KEYDOWN does).
+*/
+struct InputSnapshot
+{
+    uint16_t held    = 0,
+             pressed = 0;
+    
+    bool const is_held(int button)     const { return (held    >> button) & 1; }
+    bool const was_pressed(int button) const { return (pressed >> button) & 1; }
+};
+
+/**
+    An input log is an InputLogHeader followed by run_count InputRuns, each a snapshot
+    and how many steps in a row it lasted, so an idle stretch costs 8 bytes however long
+    it is.
+*/
+#define INPUT_LOG_MAGIC   "INP1"
+#define INPUT_LOG_VERSION 1
+
+struct InputLogHeader
+{
+    char     magic[4];
+    uint32_t version;
+    uint32_t step_count,
+             run_count;
+};
+
+struct InputRun
+{
+    uint16_t held,
+             pressed;
+    uint32_t steps;
+};
+
+/**
+    The keyboard, read one InputSnapshot per fixed step so a session can be recorded and
+    played back exactly. The game binds the keys it cares about to button numbers, calls
+    poll() once a frame to pump SDL's events, and takes next_step() at the top of every
+    fixed step. Nothing else in the game reads SDL's input.
+    
+    record() also writes every step's snapshot to a log; replay() reads them back from
+    one instead of the keyboard, and sets get_is_finished() once they run out. Only the
+    window closing is still taken from SDL while replaying.
+*/
+class Input
+{
+public:
+    enum Mode { LIVE, RECORDING, REPLAYING };
+    
+    // ————— STATIC VARIABLES ————— //
+    static constexpr int MAX_BUTTONS = 16;
+    
+private:
+    Mode m_mode = LIVE;
+    
+    SDL_Scancode m_bindings[MAX_BUTTONS];
+    int          m_binding_count = 0;
+    
+    // Built up by poll() and handed out by next_step()
+    InputSnapshot m_live;
+    
+    bool m_is_quitting = false,
+         m_is_finished = false;
+    int  m_step        = 0;
+    
+    // ————— LOG ————— //
+    FILE                 *m_file = nullptr;
+    std::vector<InputRun> m_runs;
+    size_t                m_run          = 0;     // replaying: the run we're in...
+    uint32_t              m_run_step     = 0,     // ...and how far into it
+                          m_runs_written = 0;
+    InputRun              m_pending      = { 0, 0, 0 };
+    
+    void write_pending();
+    
+public:
+    // ————— CONSTRUCTORS ————— //
+    Input();
+    ~Input();
+    
+    // ————— METHODS ————— //
+    void bind(int button, SDL_Scancode key);
+    
+    // Either of these before the first step; false if the file can't be used
+    bool record(const char *filepath);
+    bool replay(const char *filepath);
+    
+    // Finishes writing a recording; the destructor does this too
+    void close();
+    
+    void          poll();
+    InputSnapshot next_step();
+    
+    // For drivers without a keyboard (the headless tools) to stand in for one
+    void set_held(int button, bool is_held);
+    void press(int button);
+    
+    // ————— GETTERS ————— //
+    Mode const get_mode()        const { return m_mode;        }
+    bool const get_is_quitting() const { return m_is_quitting; }
+    bool const get_is_finished() const { return m_is_finished; }
+    int  const get_step()        const { return m_step;        }
+};
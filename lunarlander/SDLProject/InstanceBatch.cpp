@@ -0,0 +1,193 @@
+#define LOG(argument) std::cout << argument << '\n'
+#define VERTICES_PER_QUAD   6
+#define FLOATS_PER_INSTANCE 5
+
+#include "InstanceBatch.h"
+#include <iostream>
+
+constexpr char V_INSTANCED_SHADER_PATH[] = "shaders/vertex_instanced.glsl",
+               F_INSTANCED_SHADER_PATH[] = "shaders/fragment_textured.glsl";
+
+// The unit quad every instance is stretched from, same corners and winding as SpriteBatch
+static const float QUAD_CORNERS[VERTICES_PER_QUAD * 2] = {
+    -0.5f, -0.5f,   0.5f, -0.5f,   0.5f, 0.5f,
+    -0.5f, -0.5f,   0.5f,  0.5f,  -0.5f, 0.5f
+};
+
+// Neither entry point is core in GL 2.1, so both are looked up at run time
+typedef void (APIENTRY *VertexAttribDivisor)(GLuint index, GLuint divisor);
+typedef void (APIENTRY *DrawArraysInstanced)(GLenum mode, GLint first, GLsizei count, GLsizei instance_count);
+
+static bool g_has_checked  = false,
+            g_is_supported = false,
+            g_is_enabled   = true;
+
+static VertexAttribDivisor g_vertex_attrib_divisor = nullptr;
+static DrawArraysInstanced g_draw_arrays_instanced = nullptr;
+
+// Shared by every batch
+static ShaderProgram g_instanced_program;
+static GLint         g_offset_attribute   = -1,
+                     g_scale_attribute    = -1,
+                     g_frame_attribute    = -1,
+                     g_frame_grid_uniform = -1,
+                     g_region_uniform     = -1;
+
+// ————— SUPPORT ————— //
+bool const InstanceBatch::get_is_supported()
+{
+    if (g_has_checked) return g_is_supported;
+    g_has_checked = true;
+
+    if (!SDL_GL_ExtensionSupported("GL_ARB_instanced_arrays") || !SDL_GL_ExtensionSupported("GL_ARB_draw_instanced"))
+    {
+        LOG("InstanceBatch: no instancing, drawing through SpriteBatch");
+        return false;
+    }
+
+    g_vertex_attrib_divisor = (VertexAttribDivisor) SDL_GL_GetProcAddress("glVertexAttribDivisorARB");
+    g_draw_arrays_instanced = (DrawArraysInstanced) SDL_GL_GetProcAddress("glDrawArraysInstancedARB");
+    if (g_vertex_attrib_divisor == nullptr || g_draw_arrays_instanced == nullptr) return false;
+
+    g_instanced_program.load(V_INSTANCED_SHADER_PATH, F_INSTANCED_SHADER_PATH);
+
+    GLint link_success;
+    glGetProgramiv(g_instanced_program.get_program_id(), GL_LINK_STATUS, &link_success);
+    if (link_success == GL_FALSE) return false;
+
+    GLuint program_id = g_instanced_program.get_program_id();
+    g_offset_attribute   = glGetAttribLocation(program_id, "instanceOffset");
+    g_scale_attribute    = glGetAttribLocation(program_id, "instanceScale");
+    g_frame_attribute    = glGetAttribLocation(program_id, "instanceFrame");
+    g_frame_grid_uniform = glGetUniformLocation(program_id, "frameGrid");
+    g_region_uniform     = glGetUniformLocation(program_id, "frameRegion");
+
+    g_is_supported = g_offset_attribute >= 0 && g_scale_attribute >= 0 && g_frame_attribute >= 0;
+    return g_is_supported;
+}
+
+void InstanceBatch::set_is_enabled(bool is_enabled)
+{
+    g_is_enabled = is_enabled;
+}
+
+// ————— METHODS ————— //
+InstanceBatch::~InstanceBatch()
+{
+    if (m_quad_buffer     != 0) glDeleteBuffers(1, &m_quad_buffer);
+    if (m_instance_buffer != 0) glDeleteBuffers(1, &m_instance_buffer);
+}
+
+void InstanceBatch::begin(GLuint texture_id, const AtlasRegion &region, int frame_columns, int frame_rows)
+{
+    m_texture_id    = texture_id;
+    m_region        = region;
+    m_frame_columns = frame_columns;
+    m_frame_rows    = frame_rows;
+
+    m_instances.clear();
+}
+
+void InstanceBatch::draw(float x, float y, int frame, float scale_x, float scale_y)
+{
+    m_instances.push_back({ x, y, scale_x, scale_y, (float) frame });
+}
+
+void InstanceBatch::end(ShaderProgram *program)
+{
+    m_draw_calls     = 0;
+    m_instance_count = (int) m_instances.size();
+    m_was_instanced  = g_is_enabled && get_is_supported();
+
+    if (m_instances.empty()) return;
+
+    if (m_was_instanced) end_instanced(program);
+    else                 end_fallback(program);
+}
+
+void InstanceBatch::end_instanced(ShaderProgram *program)
+{
+    if (m_quad_buffer == 0)
+    {
+        glGenBuffers(1, &m_quad_buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, m_quad_buffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_CORNERS), QUAD_CORNERS, GL_STATIC_DRAW);
+
+        glGenBuffers(1, &m_instance_buffer);
+    }
+
+    // One upload per frame into a buffer that only grows
+    size_t bytes = m_instances.size() * sizeof(SpriteInstance);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_instance_buffer);
+    if (bytes > m_buffer_capacity)
+    {
+        m_buffer_capacity = bytes * 2;
+        glBufferData(GL_ARRAY_BUFFER, m_buffer_capacity, NULL, GL_DYNAMIC_DRAW);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, m_instances.data());
+
+    // The shadowed state means these only reach GL when the camera has moved
+    g_instanced_program.set_view_projection_matrix(program->get_view_matrix(), program->get_projection_matrix());
+    g_instanced_program.use();
+    glUniform2f(g_frame_grid_uniform, (float) m_frame_columns, (float) m_frame_rows);
+    glUniform4f(g_region_uniform, m_region.u, m_region.v, m_region.width, m_region.height);
+
+    GLuint  corner_attribute = g_instanced_program.get_position_attribute();
+    GLsizei stride           = FLOATS_PER_INSTANCE * sizeof(float);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_quad_buffer);
+    glVertexAttribPointer(corner_attribute, 2, GL_FLOAT, false, 0, (void*) 0);
+    glEnableVertexAttribArray(corner_attribute);
+
+    // These three advance once per instance rather than once per vertex
+    GLuint instance_attributes[] = { (GLuint) g_offset_attribute, (GLuint) g_scale_attribute, (GLuint) g_frame_attribute };
+    GLint  instance_sizes[]      = { 2, 2, 1 };
+    size_t instance_offsets[]    = { 0, 2 * sizeof(float), 4 * sizeof(float) };
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_instance_buffer);
+    for (int i = 0; i < 3; i++)
+    {
+        glVertexAttribPointer(instance_attributes[i], instance_sizes[i], GL_FLOAT, false, stride, (void*) instance_offsets[i]);
+        glEnableVertexAttribArray(instance_attributes[i]);
+        g_vertex_attrib_divisor(instance_attributes[i], 1);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, m_texture_id);
+    g_draw_arrays_instanced(GL_TRIANGLES, 0, VERTICES_PER_QUAD, (GLsizei) m_instances.size());
+    m_draw_calls = 1;
+
+    // Attribute slots are shared with the main program, which expects divisor 0
+    for (GLuint attribute : instance_attributes)
+    {
+        g_vertex_attrib_divisor(attribute, 0);
+        glDisableVertexAttribArray(attribute);
+    }
+    glDisableVertexAttribArray(corner_attribute);
+
+    // Everything else still draws from client-side arrays, with the caller's program
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    program->use();
+}
+
+void InstanceBatch::end_fallback(ShaderProgram *program)
+{
+    float width  = m_region.width  / m_frame_columns,
+          height = m_region.height / m_frame_rows;
+
+    m_fallback.begin();
+
+    for (const SpriteInstance &instance : m_instances)
+    {
+        int frame = (int) instance.frame;
+
+        glm::mat4 model_matrix = glm::translate(glm::mat4(1.0f), glm::vec3(instance.x, instance.y, 0.0f));
+        model_matrix = glm::scale(model_matrix, glm::vec3(instance.scale_x, instance.scale_y, 1.0f));
+
+        m_fallback.draw(m_texture_id, model_matrix, m_region.u + (frame % m_frame_columns) * width,
+                        m_region.v + (frame / m_frame_columns) * height, width, height);
+    }
+
+    m_fallback.end(program);
+    m_draw_calls = m_fallback.get_draw_calls();
+}
@@ -0,0 +1,87 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "ShaderProgram.h"
+#include "SpriteBatch.h"
+#include "TextureAtlas.h"
+
+/**
+    What the instanced shader reads per sprite: where the quad's centre goes, how big
+    it is, and which frame of the texture's grid it shows.
+*/
+struct SpriteInstance
+{
+    float x, y,
+          scale_x, scale_y,
+          frame;
+};
+
+/**
+    Draws a population of sprites that share one texture (every enemy, every lava tile)
+    with a single instanced draw call. Only SpriteInstances go to the GPU, 20 bytes a
+    sprite; shaders/vertex_instanced.glsl builds each quad and its texture coordinates
+    from them, so the CPU never touches a vertex.
+
+    Instancing needs GL_ARB_instanced_arrays and GL_ARB_draw_instanced, which a GL 2.1
+    context only has as extensions. Without them, or with set_is_enabled(false), the
+    same sprites go through a SpriteBatch instead, which also comes to one draw call.
+*/
+class InstanceBatch
+{
+private:
+    GLuint      m_texture_id    = 0;
+    AtlasRegion m_region;
+    int         m_frame_columns = 1,
+                m_frame_rows    = 1;
+
+    std::vector<SpriteInstance> m_instances;
+
+    GLuint m_quad_buffer     = 0,
+           m_instance_buffer = 0;
+    size_t m_buffer_capacity = 0; // in bytes
+
+    SpriteBatch m_fallback;
+
+    int  m_draw_calls     = 0,
+         m_instance_count = 0;
+    bool m_was_instanced  = false;
+
+    void end_instanced(ShaderProgram *program);
+    void end_fallback(ShaderProgram *program);
+
+public:
+    // ————— CONSTRUCTORS ————— //
+    InstanceBatch() = default;
+    ~InstanceBatch();
+
+    InstanceBatch(const InstanceBatch&)            = delete;
+    InstanceBatch& operator=(const InstanceBatch&) = delete;
+
+    // ————— METHODS ————— //
+    // The region of the texture is cut into a frame_columns by frame_rows grid, numbered
+    // row by row; the default region is the whole texture
+    void begin(GLuint texture_id, const AtlasRegion &region = AtlasRegion(), int frame_columns = 1, int frame_rows = 1);
+    void draw(float x, float y, int frame = 0, float scale_x = 1.0f, float scale_y = 1.0f);
+
+    // Draws with program's view and projection
+    void end(ShaderProgram *program);
+
+    // Looks for the extensions the first time; needs the GL context current
+    static bool const get_is_supported();
+    static void       set_is_enabled(bool is_enabled);
+
+    // ————— GETTERS ————— //
+    // All three describe the last end() call
+    int  const get_draw_calls()     const { return m_draw_calls;     }
+    int  const get_instance_count() const { return m_instance_count; }
+    bool const get_was_instanced()  const { return m_was_instanced;  }
+};
@@ -0,0 +1,96 @@
+#define VERTICES_PER_QUAD 6
+#define FLOATS_PER_VERTEX 4
+
+#include "SpriteBatch.h"
+#include <algorithm>
+
+SpriteBatch::~SpriteBatch()
+{
+    if (m_vertex_buffer != 0) glDeleteBuffers(1, &m_vertex_buffer);
+}
+
+void SpriteBatch::begin()
+{
+    m_quads.clear();
+}
+
+void SpriteBatch::draw(GLuint texture_id, const glm::mat4 &model_matrix, float u_coord, float v_coord, float width, float height)
+{
+    // Same corners and winding as Entity::render, moved into world space here
+    glm::vec4 bottom_left  = model_matrix * glm::vec4(-0.5f, -0.5f, 0.0f, 1.0f);
+    glm::vec4 bottom_right = model_matrix * glm::vec4( 0.5f, -0.5f, 0.0f, 1.0f);
+    glm::vec4 top_right    = model_matrix * glm::vec4( 0.5f,  0.5f, 0.0f, 1.0f);
+    glm::vec4 top_left     = model_matrix * glm::vec4(-0.5f,  0.5f, 0.0f, 1.0f);
+    
+    Quad quad = {
+        texture_id, (int) m_quads.size(),
+        {
+            bottom_left.x,  bottom_left.y,  u_coord,         v_coord + height,
+            bottom_right.x, bottom_right.y, u_coord + width, v_coord + height,
+            top_right.x,    top_right.y,    u_coord + width, v_coord,
+            bottom_left.x,  bottom_left.y,  u_coord,         v_coord + height,
+            top_right.x,    top_right.y,    u_coord + width, v_coord,
+            top_left.x,     top_left.y,     u_coord,         v_coord
+        }
+    };
+    
+    m_quads.push_back(quad);
+}
+
+void SpriteBatch::end(ShaderProgram *program)
+{
+    m_draw_calls   = 0;
+    m_sprite_count = (int) m_quads.size();
+    
+    if (m_quads.empty()) return;
+    
+    // Group by texture, keeping submission order within each texture
+    std::sort(m_quads.begin(), m_quads.end(), [](const Quad &a, const Quad &b) {
+        return a.texture_id != b.texture_id ? a.texture_id < b.texture_id : a.order < b.order;
+    });
+    
+    m_vertices.clear();
+    for (const Quad &quad : m_quads)
+        m_vertices.insert(m_vertices.end(), quad.vertices, quad.vertices + VERTICES_PER_QUAD * FLOATS_PER_VERTEX);
+    
+    // One upload per frame into a buffer that only grows
+    size_t bytes = m_vertices.size() * sizeof(float);
+    
+    if (m_vertex_buffer == 0) glGenBuffers(1, &m_vertex_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer);
+    
+    if (bytes > m_buffer_capacity)
+    {
+        m_buffer_capacity = bytes * 2;
+        glBufferData(GL_ARRAY_BUFFER, m_buffer_capacity, NULL, GL_DYNAMIC_DRAW);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, m_vertices.data());
+    
+    program->set_model_matrix(glm::mat4(1.0f));
+    
+    GLsizei stride = FLOATS_PER_VERTEX * sizeof(float);
+    
+    glVertexAttribPointer(program->get_position_attribute(), 2, GL_FLOAT, false, stride, (void*) 0);
+    glEnableVertexAttribArray(program->get_position_attribute());
+    glVertexAttribPointer(program->get_tex_coordinate_attribute(), 2, GL_FLOAT, false, stride, (void*) (2 * sizeof(float)));
+    glEnableVertexAttribArray(program->get_tex_coordinate_attribute());
+    
+    // One draw call per run of quads sharing a texture
+    int run_start = 0;
+    for (int i = 1; i <= (int) m_quads.size(); i++)
+    {
+        if (i < (int) m_quads.size() && m_quads[i].texture_id == m_quads[run_start].texture_id) continue;
+        
+        glBindTexture(GL_TEXTURE_2D, m_quads[run_start].texture_id);
+        glDrawArrays(GL_TRIANGLES, run_start * VERTICES_PER_QUAD, (i - run_start) * VERTICES_PER_QUAD);
+        m_draw_calls++;
+        
+        run_start = i;
+    }
+    
+    glDisableVertexAttribArray(program->get_position_attribute());
+    glDisableVertexAttribArray(program->get_tex_coordinate_attribute());
+    
+    // Everything else still draws from client-side arrays
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
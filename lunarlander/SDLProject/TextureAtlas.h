@@ -0,0 +1,115 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengl.h>
+
+/**
+    Where an image sits inside the texture it was packed into, in texture coordinates
+    (top left corner and size). The default is the whole texture, so an image that was
+    loaded on its own can carry one too.
+*/
+struct AtlasRegion
+{
+    float u      = 0.0f,
+          v      = 0.0f,
+          width  = 1.0f,
+          height = 1.0f;
+
+    // Takes a coordinate in the image on its own to the same spot in the atlas
+    float const map_u(float image_u) const { return u + image_u * width;  }
+    float const map_v(float image_v) const { return v + image_v * height; }
+};
+
+struct AtlasSprite
+{
+    GLuint      texture_id;     // the atlas page it landed on
+    int         width,          // of the original image, in pixels
+                height;
+    AtlasRegion region;
+};
+
+/**
+    Packs many small images into a few large textures at load time, so sprites that used
+    to need a texture each can be drawn without switching textures in between, and a
+    SpriteBatch or InstanceBatch can take them all in one draw call.
+
+    add() the images, then build() once: they're sorted tallest first and laid out in
+    shelves across pages of page_size square, and find() has each one's page and region
+    from then on. Every image gets padding pixels of its own edge copied around it, so
+    filtering at a region's border never picks up the image next door. Pages are only as
+    tall as they need to be (rounded up to a power of two), and an image too big for a
+    page gets one to itself.
+
+    Pages clamp rather than repeat, so nothing drawn from an atlas can tile its texture.
+*/
+class TextureAtlas
+{
+private:
+    struct PackedImage
+    {
+        std::string                name;
+        std::vector<unsigned char> pixels;    // RGBA, freed once it's on the GPU
+        int                        width,
+                                   height,
+                                   page = 0,
+                                   x    = 0,
+                                   y    = 0;
+        AtlasSprite                sprite;
+    };
+
+    struct Page
+    {
+        GLuint texture_id = 0;
+        int    width      = 0,
+               height     = 0;
+    };
+
+    int m_page_size,
+        m_padding;
+
+    std::vector<PackedImage> m_images;
+    std::vector<Page>        m_pages;
+    bool                     m_is_built = false;
+
+    void place_images();
+    void upload_page(int page);
+
+public:
+    // ————— STATIC VARIABLES ————— //
+    static constexpr int DEFAULT_PAGE_SIZE = 1024;
+
+    // ————— CONSTRUCTORS ————— //
+    TextureAtlas(int page_size = DEFAULT_PAGE_SIZE, int padding = 1);
+    ~TextureAtlas();
+
+    TextureAtlas(const TextureAtlas&)            = delete;
+    TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+    // ————— METHODS ————— //
+    // Copies the RGBA pixels; only before build()
+    void add(const std::string &name, const unsigned char *pixels, int width, int height);
+
+    // Decodes the image and adds it under its path; false if it can't be read
+    bool add(const char *filepath);
+
+    // Packs and uploads everything added so far; needs the GL context current
+    void build();
+
+    // nullptr for a name that was never added, or before build()
+    const AtlasSprite *find(const std::string &name) const;
+
+    // ————— GETTERS ————— //
+    int    const get_page_count()           const { return (int) m_pages.size();    }
+    int    const get_image_count()          const { return (int) m_images.size();   }
+    GLuint const get_page_texture(int page) const { return m_pages[page].texture_id; }
+    size_t const get_page_bytes()           const;
+    bool   const owns_texture(GLuint texture_id) const;
+};
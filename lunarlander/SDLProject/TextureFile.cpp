@@ -0,0 +1,180 @@
+#define LOG(argument) std::cout << argument << '\n'
+#define BYTES_PER_PIXEL 4
+#define HASH_BLOCK_SIZE 65536
+#define FNV_OFFSET      14695981039346656037ull
+#define FNV_PRIME       1099511628211ull
+
+#include "TextureFile.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WINDOWS
+#include <cstdlib>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static uint32_t align_to_pixels(size_t offset)
+{
+    return (uint32_t) ((offset + TEXTURE_FILE_PIXELS_ALIGN - 1) & ~(size_t) (TEXTURE_FILE_PIXELS_ALIGN - 1));
+}
+
+// ————— CONSTRUCTORS ————— //
+TextureFile::TextureFile(const char *image_filepath, uint32_t flags)
+{
+    std::string filepath = get_cache_path(image_filepath);
+
+#ifdef _WINDOWS
+    // No mmap here; read it into one block instead
+    FILE *file = fopen(filepath.c_str(), "rb");
+    if (file != NULL)
+    {
+        fseek(file, 0, SEEK_END);
+        m_size = (size_t) ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        m_data = malloc(m_size);
+        if (m_data != NULL && fread(m_data, 1, m_size, file) != m_size)
+        {
+            free(m_data);
+            m_data = nullptr;
+        }
+        fclose(file);
+    }
+#else
+    int file = open(filepath.c_str(), O_RDONLY);
+    struct stat status;
+
+    if (file >= 0 && fstat(file, &status) == 0 && status.st_size > 0)
+    {
+        m_size = (size_t) status.st_size;
+
+        // Nothing ever writes to the pixels: they go straight from here to the GPU
+        m_data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (m_data == MAP_FAILED) m_data = nullptr;
+    }
+
+    // The mapping keeps the file alive on its own
+    if (file >= 0) close(file);
+#endif
+
+    // No cache at all is the usual case before the converter has run, so only a cache
+    // that's there but unusable is worth a word
+    if (m_data != nullptr && !validate(image_filepath, flags))
+    {
+        LOG("Decoding " << image_filepath << " instead of using " << filepath);
+        m_header = nullptr;
+        m_pixels = nullptr;
+    }
+}
+
+TextureFile::~TextureFile()
+{
+    if (m_data == nullptr) return;
+
+#ifdef _WINDOWS
+    free(m_data);
+#else
+    munmap(m_data, m_size);
+#endif
+}
+
+// ————— METHODS ————— //
+bool TextureFile::validate(const char *image_filepath, uint32_t flags)
+{
+    const TextureFileHeader *header = (const TextureFileHeader *) m_data;
+
+    if (m_size < sizeof(TextureFileHeader) ||
+        memcmp(header->magic, TEXTURE_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != TEXTURE_FILE_VERSION || header->format != TEXTURE_FORMAT_RGBA8)
+    {
+        LOG(get_cache_path(image_filepath) << " is not a texture cache this build can read");
+        return false;
+    }
+
+    if (header->flags != flags) return false;
+
+    uint64_t pixels_size = (uint64_t) header->width * header->height * BYTES_PER_PIXEL;
+
+    if (header->pixels_size != pixels_size || header->pixels_offset % TEXTURE_FILE_PIXELS_ALIGN != 0 ||
+        header->pixels_offset + pixels_size > m_size)
+    {
+        LOG(get_cache_path(image_filepath) << " is truncated or corrupt");
+        return false;
+    }
+
+    // A cache that outlived a change to its image would draw the old one
+    uint64_t source_size, source_hash;
+    if (hash_file(image_filepath, &source_size, &source_hash) &&
+        (source_size != header->source_size || source_hash != header->source_hash))
+    {
+        LOG(get_cache_path(image_filepath) << " is stale");
+        return false;
+    }
+
+    m_header = header;
+    m_pixels = (const unsigned char *) m_data + header->pixels_offset;
+
+    return true;
+}
+
+bool TextureFile::hash_file(const char *filepath, uint64_t *size, uint64_t *hash)
+{
+    FILE *file = fopen(filepath, "rb");
+    if (file == NULL) return false;
+
+    static thread_local unsigned char block[HASH_BLOCK_SIZE];
+
+    *size = 0;
+    *hash = FNV_OFFSET;
+
+    size_t read;
+    while ((read = fread(block, 1, HASH_BLOCK_SIZE, file)) > 0)
+    {
+        for (size_t i = 0; i < read; i++) *hash = (*hash ^ block[i]) * FNV_PRIME;
+        *size += read;
+    }
+
+    bool is_read = ferror(file) == 0;
+    fclose(file);
+
+    return is_read;
+}
+
+bool TextureFile::write(const char *image_filepath, const unsigned char *pixels, int width, int height,
+                        uint32_t flags, uint64_t source_size, uint64_t source_hash)
+{
+    TextureFileHeader header;
+    memset(&header, 0, sizeof(header));
+
+    memcpy(header.magic, TEXTURE_FILE_MAGIC, sizeof(header.magic));
+    header.version       = TEXTURE_FILE_VERSION;
+    header.width         = (uint32_t) width;
+    header.height        = (uint32_t) height;
+    header.format        = TEXTURE_FORMAT_RGBA8;
+    header.flags         = flags;
+    header.source_size   = source_size;
+    header.source_hash   = source_hash;
+    header.pixels_offset = align_to_pixels(sizeof(TextureFileHeader));
+    header.pixels_size   = (uint32_t) ((size_t) width * height * BYTES_PER_PIXEL);
+
+    FILE *file = fopen(get_cache_path(image_filepath).c_str(), "wb");
+    if (file == NULL) return false;
+
+    static const char padding[TEXTURE_FILE_PIXELS_ALIGN] = { 0 };
+
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(padding, 1, header.pixels_offset - sizeof(header), file) == header.pixels_offset - sizeof(header) &&
+                   fwrite(pixels, 1, header.pixels_size, file) == header.pixels_size;
+
+    return fclose(file) == 0 && written;
+}
+
+std::string const TextureFile::get_cache_path(const char *image_filepath)
+{
+    return std::string(image_filepath) + TEXTURE_FILE_EXTENSION;
+}
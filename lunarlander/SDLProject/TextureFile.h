@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+    A decoded image on disk (.texcache), kept next to the image it came from
+    (assets/font1.png has assets/font1.png.texcache). Little-endian, laid out as:
+        TextureFileHeader
+        (padding to TEXTURE_FILE_PIXELS_ALIGN)
+        pixels[pixels_size]                   rows top to bottom, as stb_image gives them
+    source_size and source_hash describe the image the pixels were decoded from; a cache
+    whose image has changed since is stale and is never used.
+
+    Only RGBA8 is written for now. Block-compressed formats would need S3TC, which a
+    GL 2.1 context doesn't promise, and they'd smear our pixel art besides; format is
+    there so a later version can add them without breaking older files.
+    tools/texture_converter.cpp writes these from images.
+*/
+#define TEXTURE_FILE_MAGIC        "TEX1"
+#define TEXTURE_FILE_VERSION      1
+#define TEXTURE_FILE_EXTENSION    ".texcache"
+#define TEXTURE_FILE_PIXELS_ALIGN 64
+
+enum TextureFileFormat { TEXTURE_FORMAT_RGBA8 = 0 };
+
+// Bits of TextureFileHeader::flags
+#define TEXTURE_FLAG_PREMULTIPLIED 1    // colour already multiplied by alpha
+
+struct TextureFileHeader
+{
+    char     magic[4];
+    uint32_t version;
+    uint32_t width,
+             height;
+    uint32_t format;
+    uint32_t flags;
+    uint64_t source_size,
+             source_hash;
+    uint32_t pixels_offset,
+             pixels_size;
+};
+
+/**
+    Maps the .texcache next to an image, if there is one and it's still fresh, so its
+    pixels can go to glTexImage2D straight out of the mapping with nothing decoded. A
+    missing, stale or unreadable cache just leaves get_is_loaded() false, and the caller
+    decodes the image itself as it always did.
+
+    Checking freshness means reading and hashing the image file, which costs far less
+    than inflating it. Where the image itself is missing the cache is trusted as is, so
+    a build can ship caches alone.
+*/
+class TextureFile
+{
+private:
+    void  *m_data = nullptr;
+    size_t m_size = 0;
+
+    const TextureFileHeader *m_header = nullptr;
+    const unsigned char     *m_pixels = nullptr;
+
+    bool validate(const char *filepath, uint32_t flags);
+
+public:
+    // ————— CONSTRUCTORS ————— //
+    // flags has to match the cache's exactly: straight alpha pixels are no use to a caller
+    // that blends premultiplied ones, and the other way round
+    TextureFile(const char *image_filepath, uint32_t flags = 0);
+    ~TextureFile();
+
+    // Owns the mapping, so it can't be copied
+    TextureFile(const TextureFile&)            = delete;
+    TextureFile& operator=(const TextureFile&) = delete;
+
+    // ————— METHODS ————— //
+    // Writes the cache for image_filepath; pixels are width * height RGBA8
+    static bool write(const char *image_filepath, const unsigned char *pixels, int width, int height,
+                      uint32_t flags, uint64_t source_size, uint64_t source_hash);
+
+    // 64-bit FNV-1a of the whole file; false if it can't be read
+    static bool hash_file(const char *filepath, uint64_t *size, uint64_t *hash);
+
+    static std::string const get_cache_path(const char *image_filepath);
+
+    // ————— GETTERS ————— //
+    bool const get_is_loaded() const { return m_header != nullptr; }
+
+    int      const get_width()  const { return (int) m_header->width;  }
+    int      const get_height() const { return (int) m_header->height; }
+    uint32_t const get_flags()  const { return m_header->flags;        }
+
+    const unsigned char *get_pixels() const { return m_pixels; }
+};
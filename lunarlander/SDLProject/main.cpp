@@ -31,7 +31,13 @@
 #include <ctime>
 #include <vector>
 #include <cstdlib>
+#include <cstring>
 #include "Entity.h"
+#include "SpriteBatch.h"
+#include "InstanceBatch.h"
+#include "TextureAtlas.h"
+#include "Input.h"
+#include "Profiler.h"
 
 // ––––– STRUCTS AND ENUMS ––––– //
 struct GameState
@@ -44,6 +50,9 @@ struct GameState
     //Entity* safe_platform;
 };
 
+// What Input hands each step, by the bit it sits at
+enum GameButton { BUTTON_LEFT, BUTTON_RIGHT, BUTTON_THRUST, BUTTON_JUMP, BUTTON_MUSIC_OFF, BUTTON_MUSIC_ON, BUTTON_QUIT };
+
 // ––––– CONSTANTS ––––– //
 constexpr float WINDOW_SIZE_MULT = 1.5f;
 
@@ -71,13 +80,14 @@ constexpr char LAVA_FILEPATH[]    = "assets/lavaplatform.png";
 constexpr char WIN_FILEPATH[]    = "assets/WINMESSAGE.png";
 constexpr char LOSE_FILEPATH[]    = "assets/LOSEMESSAGE.png";
 
+// All five share one atlas page, so nothing on screen switches textures
+const char* const ATLAS_FILEPATHS[] = { SPRITESHEET_FILEPATH, PLATFORM_FILEPATH, LAVA_FILEPATH,
+                                        WIN_FILEPATH, LOSE_FILEPATH };
+
 
 
 
 
-constexpr int NUMBER_OF_TEXTURES = 1;
-constexpr GLint LEVEL_OF_DETAIL  = 0;
-constexpr GLint TEXTURE_BORDER   = 0;
 
 constexpr int CD_QUAL_FREQ    = 44100,
           AUDIO_CHAN_AMT  = 2,     // stereo
@@ -101,43 +111,42 @@ SDL_Window* g_display_window;
 bool g_game_is_running = true;
 
 ShaderProgram g_program;
+SpriteBatch* g_sprite_batch;
+InstanceBatch* g_platform_batch;
+InstanceBatch* g_lava_batch;
+TextureAtlas* g_atlas;
 glm::mat4 g_view_matrix, g_projection_matrix;
 
 float g_previous_ticks = 0.0f;
 float g_accumulator = 0.0f;
 
+Input g_input;
+
+// Replays a log with no window on screen and no rendering, as fast as the steps go
+bool g_is_headless = false;
+
+// Where the profiler's samples go on the way out, if anywhere
+const char *g_profile_csv_path   = nullptr,
+           *g_profile_trace_path = nullptr;
+
 bool win = false;
 bool lose = false;
 bool game_running = true;
 int fuel = 800;
 
 // ––––– GENERAL FUNCTIONS ––––– //
-GLuint load_texture(const char* filepath)
+// Every image in the game is packed into g_atlas when it starts; this is where each one landed
+const AtlasSprite& find_sprite(const char* filepath)
 {
-    int width, height, number_of_components;
-    unsigned char* image = stbi_load(filepath, &width, &height, &number_of_components, STBI_rgb_alpha);
+    const AtlasSprite* sprite = g_atlas->find(filepath);
 
-    if (image == NULL)
+    if (sprite == NULL)
     {
         LOG("Unable to load image. Make sure the path is correct.");
         assert(false);
     }
 
-    GLuint textureID;
-    glGenTextures(NUMBER_OF_TEXTURES, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL, GL_RGBA, width, height, TEXTURE_BORDER, GL_RGBA, GL_UNSIGNED_BYTE, image);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-    stbi_image_free(image);
-
-    return textureID;
+    return *sprite;
 }
 
 void initialise()
@@ -146,7 +155,7 @@ void initialise()
     g_display_window = SDL_CreateWindow("George Skydiver!",
                                       SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
                                       WINDOW_WIDTH, WINDOW_HEIGHT,
-                                      SDL_WINDOW_OPENGL);
+                                      SDL_WINDOW_OPENGL | (g_is_headless ? SDL_WINDOW_HIDDEN : 0));
 
     SDL_GLContext context = SDL_GL_CreateContext(g_display_window);
     SDL_GL_MakeCurrent(g_display_window, context);
@@ -155,6 +164,8 @@ void initialise()
     glewInit();
 #endif
 
+    Profiler::init_gpu();
+
     // ––––– VIDEO ––––– //
     glViewport(VIEWPORT_X, VIEWPORT_Y, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
 
@@ -166,10 +177,14 @@ void initialise()
     g_program.set_projection_matrix(g_projection_matrix);
     g_program.set_view_matrix(g_view_matrix);
 
-    glUseProgram(g_program.get_program_id());
+    g_program.use();
 
     glClearColor(BG_RED, BG_BLUE, BG_GREEN, BG_OPACITY);
 
+    g_sprite_batch = new SpriteBatch();
+    g_platform_batch = new InstanceBatch();
+    g_lava_batch = new InstanceBatch();
+
     // ––––– BGM ––––– //
     Mix_OpenAudio(CD_QUAL_FREQ, MIX_DEFAULT_FORMAT, AUDIO_CHAN_AMT, AUDIO_BUFF_SIZE);
 
@@ -188,20 +203,36 @@ void initialise()
     // ––––– SFX ––––– //
     g_jump_sfx = Mix_LoadWAV(SFX_FILEPATH);
 
+    // ––––– INPUT ––––– //
+    g_input.bind(BUTTON_LEFT,      SDL_SCANCODE_LEFT);
+    g_input.bind(BUTTON_RIGHT,     SDL_SCANCODE_RIGHT);
+    g_input.bind(BUTTON_THRUST,    SDL_SCANCODE_UP);
+    g_input.bind(BUTTON_JUMP,      SDL_SCANCODE_SPACE);
+    g_input.bind(BUTTON_MUSIC_OFF, SDL_SCANCODE_H);
+    g_input.bind(BUTTON_MUSIC_ON,  SDL_SCANCODE_P);
+    g_input.bind(BUTTON_QUIT,      SDL_SCANCODE_Q);
+
+    // ––––– TEXTURES ––––– //
+    g_atlas = new TextureAtlas();
+    for (const char* filepath : ATLAS_FILEPATHS) g_atlas->add(filepath);
+    g_atlas->build();
+
     // ––––– PLATFORMS ––––– //
-    GLuint platform_texture_id = load_texture(PLATFORM_FILEPATH);
-    GLuint lava_texture_id = load_texture(LAVA_FILEPATH);
+    const AtlasSprite& platform_sprite = find_sprite(PLATFORM_FILEPATH);
+    const AtlasSprite& lava_sprite = find_sprite(LAVA_FILEPATH);
     
     g_state.win_message = new Entity();
-    GLuint win_texture_id = load_texture(WIN_FILEPATH);
-    g_state.win_message -> set_texture_id(win_texture_id);
+    const AtlasSprite& win_sprite = find_sprite(WIN_FILEPATH);
+    g_state.win_message -> set_texture_id(win_sprite.texture_id);
+    g_state.win_message -> set_atlas_region(win_sprite.region);
     g_state.win_message->set_position(glm::vec3(0.0f, 0.0f, 0.0f));
     g_state.win_message->set_scale(glm::vec3 (2.0f, 2.0f, 1.0f));
     g_state.win_message->update(0.0f, NULL, NULL, 0);
     
     g_state.lose_message = new Entity();
-    GLuint lose_texture_id = load_texture(LOSE_FILEPATH);
-    g_state.lose_message -> set_texture_id(lose_texture_id);
+    const AtlasSprite& lose_sprite = find_sprite(LOSE_FILEPATH);
+    g_state.lose_message -> set_texture_id(lose_sprite.texture_id);
+    g_state.lose_message -> set_atlas_region(lose_sprite.region);
     g_state.lose_message->set_position(glm::vec3(0.0f, 0.0f, 0.0f));
     g_state.lose_message->set_scale(glm::vec3 (2.0f, 2.0f, 1.0f));
     g_state.lose_message->update(0.0f, NULL, NULL, 0);
@@ -215,7 +246,8 @@ void initialise()
     for (int i = 0; i < PLATFORM_COUNT; i++)
     {
         if (i < 3){
-            g_state.platforms[i].set_texture_id(platform_texture_id);
+            g_state.platforms[i].set_texture_id(platform_sprite.texture_id);
+            g_state.platforms[i].set_atlas_region(platform_sprite.region);
             g_state.platforms[i].set_position(glm::vec3(i - PLATFORM_COUNT / 2.0f - 1.5f, -3.75f, 0.0f));
             g_state.platforms[i].set_width(0.8f);
             g_state.platforms[i].set_height(1.0f);
@@ -223,7 +255,8 @@ void initialise()
             g_state.platforms[i].update(0.0f, NULL, NULL, 0);
         }
         else{
-            g_state.platforms[i].set_texture_id(platform_texture_id);
+            g_state.platforms[i].set_texture_id(platform_sprite.texture_id);
+            g_state.platforms[i].set_atlas_region(platform_sprite.region);
             g_state.platforms[i].set_position(glm::vec3(i - PLATFORM_COUNT / 2.0f + 2.5f, -3.75f, 0.0f));
             g_state.platforms[i].set_width(0.8f);
             g_state.platforms[i].set_height(1.0f);
@@ -233,7 +266,8 @@ void initialise()
         }
     }
     for (int i = PLATFORM_COUNT; i < PLATFORM_COUNT + LAVA_COUNT; i++){
-        g_state.platforms[i].set_texture_id(lava_texture_id);
+        g_state.platforms[i].set_texture_id(lava_sprite.texture_id);
+        g_state.platforms[i].set_atlas_region(lava_sprite.region);
         g_state.platforms[i].set_position(glm::vec3(i - LAVA_COUNT / 2.0f - 5.5f, -3.25f, 0.0f));
         g_state.platforms[i].set_width(0.8f);
         g_state.platforms[i].set_height(1.0f);
@@ -242,7 +276,7 @@ void initialise()
     }
 
     // ––––– PLAYER (GEORGE) ––––– //
-    GLuint player_texture_id = load_texture(SPRITESHEET_FILEPATH);
+    const AtlasSprite& player_sprite = find_sprite(SPRITESHEET_FILEPATH);
 
     int player_walking_animation[4][4] =
     {
@@ -255,7 +289,7 @@ void initialise()
     glm::vec3 acceleration = glm::vec3(0.0f,-9.81f * 0.01 , 0.0f);
 
     g_state.player = new Entity(
-        player_texture_id,         // texture id
+        player_sprite.texture_id,  // texture id
         1.0f,                      // speed
         acceleration,              // acceleration
         3.0f,                      // jumping power
@@ -270,6 +304,7 @@ void initialise()
         PLAYER
     );
 
+    g_state.player -> set_atlas_region(player_sprite.region);
     g_state.player -> set_position(glm::vec3(0.0f, 4.0f, 0.0f));
 
 
@@ -281,95 +316,98 @@ void initialise()
 
 void process_input()
 {
-    g_state.player->set_movement(glm::vec3(0.0f));
+    PROFILE_SCOPE("input");
+
+    // The keys themselves are read a step at a time, in step()
+    g_input.poll();
+
+    if (g_input.get_is_quitting()) g_game_is_running = false;
+
+    LOG(fuel);
+}
+
+// One fixed step: this step's keys, then the physics
+void step()
+{
+    PROFILE_SCOPE("step");
+
+    InputSnapshot input = g_input.next_step();
 
-    SDL_Event event;
-    while (SDL_PollEvent(&event))
+    // A replay that has run out of input is over
+    if (g_input.get_is_finished())
     {
-        switch (event.type) {
-            // End game
-            case SDL_QUIT:
-            case SDL_WINDOWEVENT_CLOSE:
-                g_game_is_running = false;
-                break;
-
-            case SDL_KEYDOWN:
-                switch (event.key.keysym.sym) {
-                    case SDLK_q:
-                        // Quit the game with a keystroke
-                        g_game_is_running = false;
-                        break;
-
-                    case SDLK_SPACE:
-                        // Jump
-                        if (g_state.player->get_collided_bottom())
-                        {
-                            g_state.player->jump();
-                            Mix_PlayChannel(NEXT_CHNL, g_jump_sfx, 0);
-                        }
-                        break;
-
-                    case SDLK_h:
-                        // Stop music
-                        Mix_HaltMusic();
-                        break;
-
-                    case SDLK_p:
-                        Mix_PlayMusic(g_music, -1);
-
-                    default:
-                        break;
-                }
-
-            default:
-                break;
-        }
+        g_game_is_running = false;
+        return;
+    }
+
+    Entity *player = g_state.player;
+    player->set_movement(glm::vec3(0.0f));
+
+    if (input.was_pressed(BUTTON_QUIT))
+    {
+        g_game_is_running = false;
+        return;
+    }
+
+    if (input.was_pressed(BUTTON_JUMP) && player->get_collided_bottom())
+    {
+        player->jump();
+        Mix_PlayChannel(NEXT_CHNL, g_jump_sfx, 0);
     }
 
-    const Uint8 *key_state = SDL_GetKeyboardState(NULL);
+    if (input.was_pressed(BUTTON_MUSIC_OFF)) Mix_HaltMusic();
+    if (input.was_pressed(BUTTON_MUSIC_ON))  Mix_PlayMusic(g_music, -1);
+
     //THIS IS WHERE THE COMMANDS FOR LEFT RIGHT ACCELERATION IS
     if (fuel >= 0){
-        if (key_state[SDL_SCANCODE_LEFT])
+        if (input.is_held(BUTTON_LEFT))
         {
-            g_state.player->move_left();
+            player->move_left();
             fuel -= 1;
         }
-        else if (key_state[SDL_SCANCODE_RIGHT])
+        else if (input.is_held(BUTTON_RIGHT))
         {
-            g_state.player->move_right();
+            player->move_right();
             fuel -= 1;
         }
         else{
-            g_state.player -> toggle_left(false);
-            g_state.player -> toggle_right(false);
+            player -> toggle_left(false);
+            player -> toggle_right(false);
         }
         
-        if (key_state[SDL_SCANCODE_UP])
+        if (input.is_held(BUTTON_THRUST))
         {
-            g_state.player->move_up();
+            player->move_up();
             fuel -= 1;
         }
         else{
-            g_state.player -> enable_gravity();
+            player -> enable_gravity();
         }
     }
     else{
-        g_state.player -> toggle_left(false);
-        g_state.player -> toggle_right(false);
-        g_state.player -> enable_gravity();
+        player -> toggle_left(false);
+        player -> toggle_right(false);
+        player -> enable_gravity();
     }
 
 
-    if (glm::length(g_state.player->get_movement()) > 1.0f)
+    if (glm::length(player->get_movement()) > 1.0f)
     {
-        g_state.player->normalise_movement();
+        player->normalise_movement();
     }
 
-    LOG(fuel);
+    player->update(FIXED_TIMESTEP, NULL, g_state.platforms, PLATFORM_COUNT + LAVA_COUNT);
+
+    // The round ends on the step that lands or crashes, not when it's next drawn
+    if (player->win_status())  win  = true;
+    if (player->loss_status()) lose = true;
+    if (win || lose) game_running = false;
 }
 
 void update()
 {
+    PROFILE_SCOPE("update");
+
     float ticks = (float)SDL_GetTicks() / MILLISECONDS_IN_SECOND;
     float delta_time = ticks - g_previous_ticks;
     g_previous_ticks = ticks;
@@ -382,9 +420,9 @@ void update()
         return;
     }
 
-    while (delta_time >= FIXED_TIMESTEP)
+    while (delta_time >= FIXED_TIMESTEP && game_running && g_game_is_running)
     {
-        g_state.player->update(FIXED_TIMESTEP, NULL, g_state.platforms, PLATFORM_COUNT + LAVA_COUNT);
+        step();
 
         delta_time -= FIXED_TIMESTEP;
     }
@@ -394,31 +432,49 @@ void update()
 
 void render()
 {
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    g_state.player->render(&g_program);
-
-    for (int i = 0; i < PLATFORM_COUNT + LAVA_COUNT; i++) g_state.platforms[i].render(&g_program);
-    //for (int i = 0; i < LAVA_COUNT; i++) g_state.lava[i].render(&g_program);
+    {
+        PROFILE_SCOPE("render");
+        PROFILE_GPU_SCOPE("render");
+
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        // The platforms and the lava each go out as one instanced draw, then the player
+        g_platform_batch->begin(g_state.platforms[0].get_texture_id(), g_state.platforms[0].get_atlas_region());
+        for (int i = 0; i < PLATFORM_COUNT; i++)
+            g_platform_batch->draw(g_state.platforms[i].get_position().x, g_state.platforms[i].get_position().y);
+        g_platform_batch->end(&g_program);
+
+        g_lava_batch->begin(g_state.platforms[PLATFORM_COUNT].get_texture_id(), g_state.platforms[PLATFORM_COUNT].get_atlas_region());
+        for (int i = PLATFORM_COUNT; i < PLATFORM_COUNT + LAVA_COUNT; i++)
+            g_lava_batch->draw(g_state.platforms[i].get_position().x, g_state.platforms[i].get_position().y);
+        g_lava_batch->end(&g_program);
+
+        g_sprite_batch->begin();
+        g_state.player->render(g_sprite_batch);
+        g_sprite_batch->end(&g_program);
+        //for (int i = 0; i < LAVA_COUNT; i++) g_state.lava[i].render(&g_program);
     
-    //RENDER AFTER GAME IS OVER
-    if (g_state.player -> win_status() == true){
-        win = true;
-        game_running = false;
-        g_state.win_message -> render(&g_program);
-    }
-    if (g_state.player -> loss_status() == true){
-        lose = true;
-        game_running = false;
-        g_state.lose_message -> render(&g_program);
+        //RENDER AFTER GAME IS OVER
+        if (win)  g_state.win_message  -> render(&g_program);
+        if (lose) g_state.lose_message -> render(&g_program);
     }
 
-
+    PROFILE_SCOPE("swap");
     SDL_GL_SwapWindow(g_display_window);
 }
 
 void shutdown()
 {
+    g_input.close();
+
+    if (g_profile_csv_path   != nullptr) Profiler::write_csv(g_profile_csv_path);
+    if (g_profile_trace_path != nullptr) Profiler::write_chrome_trace(g_profile_trace_path);
+    Profiler::shutdown_gpu();
+
+    delete g_sprite_batch;
+    delete g_platform_batch;
+    delete g_lava_batch;
+    delete g_atlas;
     SDL_Quit();
 
     delete [] g_state.platforms;
@@ -426,18 +482,72 @@ void shutdown()
 }
 
 // ––––– GAME LOOP ––––– //
+// Replays the log step after step with nothing drawn, then reports where it ended up
+void run_headless()
+{
+    Uint32 start_ticks = SDL_GetTicks();
+
+    // Each step is a frame as far as the profiler is concerned
+    while (g_game_is_running && game_running)
+    {
+        Profiler::begin_frame();
+        step();
+        Profiler::end_frame();
+    }
+
+    float seconds = (SDL_GetTicks() - start_ticks) / MILLISECONDS_IN_SECOND;
+    glm::vec3 position = g_state.player->get_position();
+
+    std::cout << "steps: " << g_input.get_step() << '\n'
+              << "result: " << (win ? "win" : lose ? "lose" : "unfinished") << '\n'
+              << "position: " << position.x << ", " << position.y << '\n'
+              << "fuel: " << fuel << '\n';
+    if (seconds > 0.0f) std::cout << "speed: " << g_input.get_step() * FIXED_TIMESTEP / seconds << "x real time\n";
+}
+
 int main(int argc, char* argv[])
 {
+    for (int i = 1; i < argc; i++)
+    {
+        bool has_value = i + 1 < argc;
+
+        // Every fixed step's keys, to a log or back out of one
+        if      (strcmp(argv[i], "--record") == 0 && has_value && !g_input.record(argv[++i])) return 1;
+        else if (strcmp(argv[i], "--replay") == 0 && has_value && !g_input.replay(argv[++i])) return 1;
+        else if (strcmp(argv[i], "--headless") == 0) g_is_headless = true;
+
+        // The last Profiler::RING_SIZE timings, as a CSV or a Chrome trace
+        else if (strcmp(argv[i], "--profile-csv")   == 0 && has_value) g_profile_csv_path   = argv[++i];
+        else if (strcmp(argv[i], "--profile-trace") == 0 && has_value) g_profile_trace_path = argv[++i];
+    }
+
+    if (g_is_headless && g_input.get_mode() != Input::REPLAYING)
+    {
+        LOG("--headless needs a log to --replay");
+        return 1;
+    }
+
     initialise();
 
+    if (g_is_headless)
+    {
+        run_headless();
+        shutdown();
+        return 0;
+    }
+
     while (g_game_is_running)
     {
+        Profiler::begin_frame();
+
         process_input();
         
         if(game_running == true){
             update();
         }
             render();
+
+        Profiler::end_frame();
     }
 
     shutdown();